@@ -140,8 +140,29 @@ typedef struct {
   void (*decrefp)(json_t **json);
   json_t *(*incref)(json_t *json);
 
+  /* prehashed keys, check JANSSON_API_VERSION_PREHASHED before use */
+  size_t (*object_key_hash)(const char *key, size_t key_len);
+  json_t *(*object_getn_hashed)(
+    const json_t *object,
+    const char *key,
+    size_t key_len,
+    size_t hash);
+  int (*object_setn_hashed)(
+    json_t *object,
+    const char *key,
+    size_t key_len,
+    size_t hash,
+    json_t *value);
+  int (*object_deln_hashed)(
+    json_t *object,
+    const char *key,
+    size_t key_len,
+    size_t hash);
+
 } jansson_api_t;
 
+#define JANSSON_API_VERSION_PREHASHED 0x0002
+
 extern const jansson_api_t jansson_api;
 
 #if defined __link
@@ -1,11 +1,47 @@
+#include <string.h>
+
 #include <sdk/types.h>
 
 #include "jansson/jansson_api.h"
 
+#include "hashtable.h"
+#include "jansson_private.h"
+#include "lookup3.h"
+
+/*
+ * The prehashed get and set functions below read jansson's private
+ * hashtable (hash_str(), hashtable_seed, struct hashtable_pair and the
+ * bucket lists) as it is in 2.14. Check them against hashtable.c before
+ * changing the jansson version.
+ */
+#if JANSSON_VERSION_HEX != 0x020e00
+#error "jansson_api.c prehashed key functions need review for this jansson"
+#endif
+
+extern volatile uint32_t hashtable_seed;
+
+static size_t jansson_api_object_key_hash(const char *key, size_t key_len);
+static json_t *jansson_api_object_getn_hashed(
+	const json_t *json,
+	const char *key,
+	size_t key_len,
+	size_t hash);
+static int jansson_api_object_setn_hashed(
+	json_t *json,
+	const char *key,
+	size_t key_len,
+	size_t hash,
+	json_t *value);
+static int jansson_api_object_deln_hashed(
+	json_t *json,
+	const char *key,
+	size_t key_len,
+	size_t hash);
+
 const jansson_api_t jansson_api = {
 	.sos_api = {
 		.name = "jansson",
-		.version = 0x0001,
+		.version = 0x0002,
 		.git_hash = CMSDK_GIT_HASH,
 	},
 	.create_object = json_object,
@@ -83,5 +119,121 @@ const jansson_api_t jansson_api = {
 	.dump_callback = json_dump_callback,
 	.decref = json_decref,
 	.decrefp = json_decrefp,
-	.incref = json_incref
+	.incref = json_incref,
+	.object_key_hash = jansson_api_object_key_hash,
+	.object_getn_hashed = jansson_api_object_getn_hashed,
+	.object_setn_hashed = jansson_api_object_setn_hashed,
+	.object_deln_hashed = jansson_api_object_deln_hashed
 };
+
+/* same hash as hash_str() in hashtable.c */
+static size_t jansson_api_object_key_hash(const char *key, size_t key_len) {
+	/* picks the seed if no object has been created yet */
+	json_object_seed(0);
+	return (size_t)hashlittle(key, key_len, hashtable_seed);
+}
+
+/* hashtable_find_pair() (jansson 2.14 layout) */
+static struct hashtable_pair *jansson_api_find_pair(
+	hashtable_t *hashtable,
+	struct hashtable_bucket *bucket,
+	const char *key,
+	size_t key_len,
+	size_t hash) {
+	struct hashtable_list *list;
+
+	if (bucket->first == &hashtable->list && bucket->first == bucket->last) {
+		return NULL;
+	}
+
+	list = bucket->first;
+	while (1) {
+		struct hashtable_pair *pair
+			= container_of(list, struct hashtable_pair, list);
+		if (
+			pair->hash == hash && pair->key_len == key_len
+			&& memcmp(pair->key, key, key_len) == 0) {
+			return pair;
+		}
+		if (list == bucket->last) {
+			return NULL;
+		}
+		list = list->next;
+	}
+}
+
+static struct hashtable_bucket *
+jansson_api_bucket(hashtable_t *hashtable, size_t hash) {
+	return &hashtable->buckets[hash & (((size_t)1 << hashtable->order) - 1)];
+}
+
+/* hashtable_get() without hashing the key */
+static json_t *jansson_api_object_getn_hashed(
+	const json_t *json,
+	const char *key,
+	size_t key_len,
+	size_t hash) {
+	hashtable_t *hashtable;
+	struct hashtable_pair *pair;
+
+	if (!key || !json_is_object(json)) {
+		return NULL;
+	}
+
+	hashtable = &json_to_object((json_t *)json)->hashtable;
+	pair = jansson_api_find_pair(
+		hashtable,
+		jansson_api_bucket(hashtable, hash),
+		key,
+		key_len,
+		hash);
+	return pair ? pair->value : NULL;
+}
+
+/*
+ * json_object_setn() that replaces an existing value without hashing the
+ * key. A new key goes through json_object_setn() because adding a pair may
+ * need the table to grow.
+ */
+static int jansson_api_object_setn_hashed(
+	json_t *json,
+	const char *key,
+	size_t key_len,
+	size_t hash,
+	json_t *value) {
+	hashtable_t *hashtable;
+	struct hashtable_pair *pair;
+
+	if (!key || !value || !json_is_object(json) || json == value) {
+		return -1;
+	}
+
+	hashtable = &json_to_object(json)->hashtable;
+	pair = jansson_api_find_pair(
+		hashtable,
+		jansson_api_bucket(hashtable, hash),
+		key,
+		key_len,
+		hash);
+	if (!pair) {
+		return json_object_setn(json, key, key_len, value);
+	}
+
+	json_incref(value);
+	json_decref(pair->value);
+	pair->value = value;
+	return 0;
+}
+
+/*
+ * Removing a pair updates the bucket lists and the table size, so it goes
+ * through json_object_deln() instead of a copy of hashtable_do_del().
+ */
+static int jansson_api_object_deln_hashed(
+	json_t *json,
+	const char *key,
+	size_t key_len,
+	size_t hash) {
+	(void)hash;
+	return json_object_deln(json, key, key_len);
+}
@@ -7,7 +7,19 @@ namespace json {
 }
 
 #include "json/Json.hpp"
+#include "json/JsonArrayIndex.hpp"
 #include "json/JsonDocument.hpp"
+#include "json/JsonIncrementalParser.hpp"
+#include "json/JsonLazyValue.hpp"
+#include "json/JsonObjectIndex.hpp"
+#include "json/JsonPath.hpp"
+#include "json/JsonPointer.hpp"
+#include "json/JsonQuery.hpp"
+#include "json/JsonReader.hpp"
+#include "json/JsonSeekIndex.hpp"
+#include "json/JsonStruct.hpp"
+#include "json/JsonTypedArray.hpp"
+#include "json/JsonWriter.hpp"
 #include "json/macros.hpp"
 
 using namespace json;
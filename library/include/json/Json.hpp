@@ -3,6 +3,9 @@
 #ifndef JSONAPI_JSON_JSON_HPP_
 #define JSONAPI_JSON_JSON_HPP_
 
+#include <atomic>
+#include <string>
+
 #include <jansson/jansson_api.h>
 
 #include <api/api.hpp>
@@ -17,6 +20,7 @@ namespace json {
 #undef FALSE
 
 class JsonDocument;
+class JsonPath;
 
 class JsonError {
 public:
@@ -29,11 +33,14 @@ public:
 
 private:
   friend class JsonDocument;
+  friend class JsonReader;
+  friend class JsonIncrementalParser;
   json_error_t m_value;
 };
 
 class JsonObject;
 class JsonArray;
+class JsonRef;
 class JsonReal;
 class JsonNull;
 class JsonInteger;
@@ -41,6 +48,97 @@ class JsonString;
 
 typedef api::Api<jansson_api_t, JANSSON_API_REQUEST> JsonApi;
 
+/*
+ * Object key with its hash computed once, for keys that are looked up over
+ * and over.
+ *
+ * static const auto key = JsonKey::literal("name");
+ * object.at(key);
+ *
+ * const JsonOwnedKey id(config.get_id_key());
+ * object.insert(id, JsonInteger(5)).remove(id);
+ *
+ * A JsonKey refers to its string and is constant initialized, so a static
+ * literal key costs nothing at startup. JsonOwnedKey copies a runtime string.
+ * jansson seeds its hash function at runtime, so the hash is computed on
+ * first use instead of at compile time. Objects fall back to hashing the key
+ * if the jansson API doesn't support prehashed keys.
+ *
+ */
+class JsonKey {
+public:
+  // key must be a string literal or otherwise outlive the JsonKey
+  template <size_t Size>
+  static constexpr JsonKey literal(const char (&key)[Size]) {
+    return JsonKey(key, std::char_traits<char>::length(key));
+  }
+
+  JsonKey(const JsonKey &a)
+    : m_key(a.m_key), m_length(a.m_length),
+      m_hash(a.m_hash.load(std::memory_order_relaxed)) {}
+
+  JsonKey &operator=(const JsonKey &a) {
+    m_key = a.m_key;
+    m_length = a.m_length;
+    m_hash.store(
+      a.m_hash.load(std::memory_order_relaxed),
+      std::memory_order_relaxed);
+    return *this;
+  }
+
+  const char *cstring() const { return m_key; }
+  size_t length() const { return m_length; }
+  var::StringView string_view() const {
+    return var::StringView(m_key, m_length);
+  }
+
+  // 0 if prehashed keys aren't supported
+  size_t hash() const;
+
+  bool operator==(const JsonKey &a) const {
+    const size_t hash = m_hash.load(std::memory_order_relaxed);
+    const size_t a_hash = a.m_hash.load(std::memory_order_relaxed);
+    return m_length == a.m_length
+           && (hash == 0 || a_hash == 0 || hash == a_hash)
+           && string_view() == a.string_view();
+  }
+  bool operator!=(const JsonKey &a) const { return !(*this == a); }
+
+protected:
+  constexpr JsonKey(const char *key, size_t length)
+    : m_key(key), m_length(length) {}
+
+  const char *m_key;
+
+private:
+  size_t m_length;
+  // 0 until the first call to hash(), shared keys are read by many threads
+  mutable std::atomic<size_t> m_hash{0};
+};
+
+// JsonKey that keeps a copy of its string
+class JsonOwnedKey : public JsonKey {
+public:
+  explicit JsonOwnedKey(const var::StringView key)
+    : JsonKey(nullptr, key.length()), m_storage(key) {
+    m_key = m_storage.cstring();
+  }
+
+  JsonOwnedKey(const JsonOwnedKey &a) : JsonKey(a), m_storage(a.m_storage) {
+    m_key = m_storage.cstring();
+  }
+
+  JsonOwnedKey &operator=(const JsonOwnedKey &a) {
+    JsonKey::operator=(a);
+    m_storage = a.m_storage;
+    m_key = m_storage.cstring();
+    return *this;
+  }
+
+private:
+  var::String m_storage;
+};
+
 class JsonValue : public api::ExecutionContext {
 public:
 
@@ -94,6 +192,7 @@ public:
   JsonArray &to_array();
 
   JsonValue lookup(const var::StringView key_path) const;
+  JsonValue lookup(const JsonPath &path) const;
 
 
   const char *to_cstring() const;
@@ -122,11 +221,21 @@ public:
 
   static JsonApi &api() { return m_api; }
 
+  // true if the jansson API has the prehashed key functions
+  static bool is_prehashed_key_supported() {
+    return api()->sos_api.version >= JANSSON_API_VERSION_PREHASHED;
+  }
+
   const json_t * native_value() const {
     return m_value;
   }
 
   JsonValue find(const var::StringView path, const char* delimiter = "/") const;
+  // path is parsed once, see JsonPath
+  JsonValue find(const JsonPath &path) const;
+
+  // borrowed view for read-only traversal, see JsonRef
+  JsonRef view() const;
 
 protected:
   struct Key {
@@ -146,6 +255,10 @@ protected:
 
 private:
   friend class JsonDocument;
+  friend class JsonWriter;
+  friend class JsonLazyValue;
+  friend class JsonIncrementalParser;
+  friend class JsonPointer;
   friend class JsonObjectIterator;
   friend class JsonArrayIterator;
   friend class JsonObject;
@@ -157,6 +270,7 @@ private:
   friend class JsonString;
   friend class JsonNull;
   friend class JsonKeyValue;
+  template <typename T> friend class JsonTypedArray;
   static JsonApi m_api;
 
   json_t *m_value = nullptr;
@@ -202,6 +316,95 @@ public:
   }
 };
 
+class JsonRefIterator {
+public:
+  JsonRefIterator() = default;
+
+  bool operator!=(JsonRefIterator const &a) const noexcept {
+    return m_index != a.m_index || m_json_iter != a.m_json_iter;
+  }
+
+  JsonRef operator*() const noexcept;
+
+  // member key when iterating an object, empty for an array
+  var::StringView key() const noexcept;
+
+  JsonRefIterator &operator++();
+
+private:
+  friend class JsonRef;
+  JsonRefIterator(const json_t *value, size_t index, void *iter)
+    : m_json_value(value), m_index(index), m_json_iter(iter) {}
+
+  const json_t *m_json_value = nullptr;
+  size_t m_index = 0;
+  void *m_json_iter = nullptr;
+};
+
+/*
+ * Borrowed, read-only view of a value. Unlike JsonValue, creating or
+ * copying a JsonRef doesn't change the reference count, so walking a large
+ * document writes nothing to it. The value must outlive the JsonRef.
+ *
+ * for (const JsonRef item : list.view()) {
+ *   total += item.at("value").to_integer();
+ * }
+ *
+ */
+class JsonRef {
+public:
+  JsonRef() = default;
+  explicit JsonRef(const json_t *value) : m_value(value) {}
+
+  bool is_valid() const { return m_value != nullptr; }
+
+  JsonValue::Type type() const {
+    if (m_value) {
+      return static_cast<JsonValue::Type>(json_typeof(m_value));
+    }
+    return JsonValue::Type::invalid;
+  }
+
+  bool is_object() const { return type() == JsonValue::Type::object; }
+  bool is_array() const { return type() == JsonValue::Type::array; }
+  bool is_string() const { return type() == JsonValue::Type::string; }
+  bool is_real() const { return type() == JsonValue::Type::real; }
+  bool is_integer() const { return type() == JsonValue::Type::integer; }
+  bool is_true() const { return type() == JsonValue::Type::true_; }
+  bool is_false() const { return type() == JsonValue::Type::false_; }
+  bool is_null() const { return type() == JsonValue::Type::null; }
+
+  const char *to_cstring() const;
+  var::StringView to_string_view() const {
+    return var::StringView(to_cstring());
+  }
+
+  float to_real() const;
+  int to_integer() const;
+  bool to_bool() const;
+
+  // members of an object or elements of an array, otherwise 0
+  size_t count() const;
+
+  // array element
+  JsonRef at(size_t offset) const;
+  // object member
+  JsonRef at(const var::StringView key) const;
+  JsonRef at(const JsonKey &key) const;
+
+  // iterates the elements of an array or the members of an object
+  JsonRefIterator begin() const;
+  JsonRefIterator end() const;
+
+  // takes a reference to the value
+  JsonValue to_value() const;
+
+  const json_t *native_value() const { return m_value; }
+
+private:
+  const json_t *m_value = nullptr;
+};
+
 class JsonObjectIterator : private JsonApi {
 public:
 
@@ -219,6 +422,10 @@ public:
 
   JsonValue operator*() const noexcept;
 
+  var::StringView key() const noexcept {
+    return api()->object_iter_key(m_json_iter);
+  }
+
   JsonObjectIterator &operator++() {
     m_json_iter = api()->object_iter_next(m_json_value, m_json_iter);
     return *this;
@@ -279,12 +486,14 @@ public:
   bool is_empty() const { return count() == 0; }
 
   JsonObject &insert(const var::StringView key, const JsonValue &value);
+  JsonObject &insert(const JsonKey &key, const JsonValue &value);
 
   JsonObject &insert(const JsonKeyValue &key_value) {
     return insert(key_value.key(), key_value.value());
   }
 
   JsonObject &insert_bool(const var::StringView key, bool value);
+  JsonObject &insert_bool(const JsonKey &key, bool value);
 
   enum class UpdateFlags {
     null = 0x00,
@@ -298,12 +507,21 @@ public:
                      UpdateFlags o_flags = UpdateFlags::null);
 
   JsonObject &remove(const var::StringView key);
+  // still hashes the key, see jansson_api_object_deln_hashed()
+  JsonObject &remove(const JsonKey &key);
   u32 count() const;
   JsonObject &clear();
 
   JsonValue at(const var::StringView key) const;
+  JsonValue at(const JsonKey &key) const;
+  // walks the members from the first one, so a loop over every offset is
+  // O(n^2); use JsonObjectIndex or iterate the object instead
   JsonValue at(size_t offset) const;
 
+  // borrowed members, see JsonRef
+  JsonRef view_at(const var::StringView key) const;
+  JsonRef view_at(const JsonKey &key) const;
+
   KeyList get_key_list() const;
 
 private:
@@ -397,6 +615,8 @@ public:
   u32 count() const;
 
   JsonValue at(size_t position) const;
+  // borrowed element, see JsonRef
+  JsonRef view_at(size_t position) const;
   JsonArray &append(const JsonValue &value);
 
   JsonArray &append(const JsonArray &array);
@@ -411,8 +631,54 @@ public:
   var::Vector<float> float_list() const;
   var::Vector<bool> bool_list() const;
 
+  enum class IsStrict { no, yes };
+
+  // Bulk copies that read each element in place without creating a
+  // JsonValue. Values are converted like to_integer(), to_real(), to_bool()
+  // and to_cstring(); with IsStrict::yes an element of another type stops
+  // the copy with an error. The pointer versions copy at most size elements
+  // starting at offset and return the number copied.
+  size_t copy_to(
+    s32 *list,
+    size_t size,
+    size_t offset = 0,
+    IsStrict is_strict = IsStrict::no) const;
+  size_t copy_to(
+    float *list,
+    size_t size,
+    size_t offset = 0,
+    IsStrict is_strict = IsStrict::no) const;
+  size_t copy_to(
+    bool *list,
+    size_t size,
+    size_t offset = 0,
+    IsStrict is_strict = IsStrict::no) const;
+  size_t copy_to(
+    var::StringView *list,
+    size_t size,
+    size_t offset = 0,
+    IsStrict is_strict = IsStrict::no) const;
+
+  // replaces the contents of list
+  const JsonArray &
+  copy_to(var::Vector<s32> &list, IsStrict is_strict = IsStrict::no) const;
+  const JsonArray &
+  copy_to(var::Vector<float> &list, IsStrict is_strict = IsStrict::no) const;
+  const JsonArray &
+  copy_to(var::Vector<bool> &list, IsStrict is_strict = IsStrict::no) const;
+  const JsonArray &copy_to(
+    var::StringViewList &list,
+    IsStrict is_strict = IsStrict::no) const;
+
 private:
   static json_t *create();
+
+  template <typename Output>
+  size_t copy_values(
+    size_t size,
+    size_t offset,
+    IsStrict is_strict,
+    Output output) const;
 };
 
 class JsonString : public JsonValue {
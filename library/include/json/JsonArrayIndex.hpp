@@ -0,0 +1,51 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#ifndef JSONAPI_JSON_JSONARRAYINDEX_HPP
+#define JSONAPI_JSON_JSONARRAYINDEX_HPP
+
+#include <fs/File.hpp>
+#include <var/Vector.hpp>
+
+#include "Json.hpp"
+
+namespace json {
+
+/*
+ * Element offsets of a file that is one top-level array, built in one pass.
+ * The index can be saved next to the file and loaded later, then
+ * JsonDocument::load_element() and JsonDocument::load_elements() read only
+ * the bytes of the requested elements.
+ *
+ * JsonArrayIndex index;
+ * index.build(fs::File("records.json"));
+ * index.save(fs::File(fs::File::IsOverwrite::yes, "records.json.index"));
+ *
+ */
+class JsonArrayIndex : public api::ExecutionContext {
+public:
+  JsonArrayIndex &build(const fs::FileObject &file);
+
+  // sidecar format, one offset per line after the header
+  const JsonArrayIndex &save(const fs::FileObject &file) const;
+  JsonArrayIndex &load(const fs::FileObject &file);
+
+  size_t count() const {
+    return m_offset_list.count() ? m_offset_list.count() - 1 : 0;
+  }
+
+  // bytes of elements [begin, end) without the separators around them
+  size_t start(size_t begin) const { return m_offset_list.at(begin) + 1; }
+  size_t end(size_t end) const { return m_offset_list.at(end); }
+
+  // size of the file when the index was built
+  size_t source_size() const { return m_source_size; }
+
+private:
+  size_t m_source_size = 0;
+  // offsets of the opening [, each comma and the closing ]
+  var::Vector<size_t> m_offset_list;
+};
+
+} // namespace json
+
+#endif // JSONAPI_JSON_JSONARRAYINDEX_HPP
@@ -8,6 +8,8 @@
 #include <var/StringView.hpp>
 
 #include "Json.hpp"
+#include "JsonArrayIndex.hpp"
+#include "JsonSeekIndex.hpp"
 
 namespace json {
 
@@ -42,9 +44,60 @@ public:
 
   Flags option_flags() const { return m_flags; }
 
+#if defined __link
+  static constexpr size_t default_write_buffer_size = 64 * 1024;
+#else
+  static constexpr size_t default_write_buffer_size = 256;
+#endif
+
+  // output from save() is combined into writes of this size (0 to disable)
+  JsonDocument &set_write_buffer_size(size_t value) {
+    m_write_buffer_size = value;
+    return *this;
+  }
+
+  size_t write_buffer_size() const { return m_write_buffer_size; }
+
 
   JsonValue load(const fs::FileObject &file);
 
+  // only creates the values on the listed paths (same syntax as
+  // JsonValue::find()), skipped array elements before a selected one are null
+  JsonValue
+  load(const fs::FileObject &file, const var::StringViewList &projection);
+
+  // maps the file into memory (when supported) and parses it in one pass
+  JsonValue load_mapped(const var::StringView path);
+
+  // called for each record in a JSON Lines file, value is invalid and error
+  // has the line number if the record can't be parsed; return false to stop
+  using LineCallback
+    = bool (*)(const JsonValue &value, const JsonError &error, void *context);
+
+  JsonDocument &for_each_line(
+    const fs::FileObject &file,
+    LineCallback callback,
+    void *context = nullptr);
+
+#if defined __link
+  enum class IsOrdered { no, yes };
+
+  class ParallelOptions {
+    // 0 uses one thread per core
+    API_AF(ParallelOptions, size_t, thread_count, 0);
+    API_AF(ParallelOptions, size_t, chunk_size, 1024 * 1024);
+    API_AF(ParallelOptions, IsOrdered, is_ordered, IsOrdered::yes);
+  };
+
+  // records are parsed on a pool of threads, the callback is still called
+  // on the calling thread (in file order unless is_ordered is no)
+  JsonDocument &for_each_line(
+    const fs::FileObject &file,
+    const ParallelOptions &options,
+    LineCallback callback,
+    void *context = nullptr);
+#endif
+
 #if defined __link
   enum class IsXmlFlat { no, yes };
 
@@ -57,8 +110,15 @@ public:
 
 
   JsonValue from_string(const var::StringView json);
+  JsonValue from_string(
+    const var::StringView json,
+    const var::StringViewList &projection);
   var::String to_string(const JsonValue &value) const;
 
+  // replaces the contents of output, its capacity is kept between calls
+  const JsonDocument &
+  to_string(const JsonValue &value, var::String &output) const;
+
   var::String stringify(const JsonValue &value) const {
     return to_string(value);
   }
@@ -74,12 +134,58 @@ public:
     return API_CONST_CAST_SELF(JsonDocument, seek, path, file);
   }
 
+  // jumps to the deepest container on path that is in index and scans the
+  // rest of the path from there, an error if index was built from a file of
+  // another size
+  const JsonDocument &seek(
+    const var::StringView path,
+    const fs::FileObject &file,
+    const JsonSeekIndex &index) const;
+  JsonDocument &seek(
+    const var::StringView path,
+    const fs::FileObject &file,
+    const JsonSeekIndex &index) {
+    return API_CONST_CAST_SELF(JsonDocument, seek, path, file, index);
+  }
+
+  // finds several objects or arrays in one pass and stops once all are
+  // found, entries are in the order of path_list and invalid if not found
+  // or cut off by the end of the file; the file is left where the scan
+  // stopped
+  var::Vector<JsonSeekIndex::Entry> seek_many(
+    const var::StringViewList &path_list,
+    const fs::FileObject &file) const;
+
+  // loads the object or array at path with one read of exactly its bytes
+  JsonValue load_at(const var::StringView path, const fs::FileObject &file);
+  JsonValue load_at(
+    const var::StringView path,
+    const fs::FileObject &file,
+    const JsonSeekIndex &index);
+  // loads an entry from seek_many() or JsonSeekIndex
+  JsonValue
+  load_at(const JsonSeekIndex::Entry &entry, const fs::FileObject &file);
+
+  // element i of a file that is one top-level array, an error if index was
+  // built from a file of another size
+  JsonValue load_element(
+    const fs::FileObject &file,
+    const JsonArrayIndex &index,
+    size_t i);
+  // elements [begin, end) with one read
+  JsonArray load_elements(
+    const fs::FileObject &file,
+    const JsonArrayIndex &index,
+    size_t begin,
+    size_t end);
+
   const JsonError &error() const { return m_error; }
 
   static bool is_valid(const fs::FileObject & file, printer::Printer *printer = nullptr);
 
 private:
   Flags m_flags = Flags::indent3;
+  size_t m_write_buffer_size = default_write_buffer_size;
   JsonError m_error;
 
   u32 json_flags() const { return static_cast<u32>(option_flags()); }
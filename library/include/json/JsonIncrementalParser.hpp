@@ -0,0 +1,94 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#ifndef JSONAPI_JSON_JSONINCREMENTALPARSER_HPP
+#define JSONAPI_JSON_JSONINCREMENTALPARSER_HPP
+
+#include <var/Data.hpp>
+#include <var/View.hpp>
+
+#include "JsonDocument.hpp"
+
+namespace json {
+
+/*
+ * Push parser for input that arrives in pieces (pipes, sockets, serial
+ * links). Chunks can split values anywhere; only the bytes of the value in
+ * progress are kept between calls to feed(). Each complete top-level value is
+ * passed to the callback as soon as its last byte arrives. Values can be
+ * separated by whitespace (e.g. JSON Lines) or simply concatenated.
+ *
+ * JsonIncrementalParser parser(callback, &context);
+ * while (...) {
+ *   parser.feed(View(buffer, count));
+ * }
+ * parser.finish();
+ *
+ */
+class JsonIncrementalParser : public api::ExecutionContext {
+public:
+  using Flags = JsonDocument::Flags;
+
+  // value is invalid and error is set when a value can't be parsed, return
+  // false to stop delivering values until the next feed()
+  using Callback = JsonDocument::LineCallback;
+
+  explicit JsonIncrementalParser(Callback callback, void *context = nullptr)
+    : m_callback(callback), m_context(context) {}
+
+  JsonIncrementalParser &set_flags(Flags flags) {
+    m_flags = flags;
+    return *this;
+  }
+
+  Flags option_flags() const { return m_flags; }
+
+  // largest value that will be buffered (0 for no limit)
+  JsonIncrementalParser &set_maximum_size(size_t value) {
+    m_maximum_size = value;
+    return *this;
+  }
+
+  size_t maximum_size() const { return m_maximum_size; }
+
+  JsonIncrementalParser &feed(const var::View data);
+
+  // ends the input, a number at the end is delivered and an unfinished
+  // value is an error
+  JsonIncrementalParser &finish();
+
+  // discards buffered input
+  JsonIncrementalParser &reset();
+
+  // bytes of the value in progress
+  size_t pending_size() const { return m_length - m_consumed; }
+
+private:
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  Callback m_callback;
+  void *m_context;
+  Flags m_flags = Flags::decode_any;
+  size_t m_maximum_size = 0;
+
+  var::Data m_buffer;
+  size_t m_length = 0;
+  size_t m_consumed = 0;
+  size_t m_scan_offset = 0;
+  size_t m_value_start = npos;
+  size_t m_depth = 0;
+  bool m_is_scalar = false;
+  bool m_is_string = false;
+  bool m_is_escape = false;
+
+  u32 json_flags() const {
+    return static_cast<u32>(option_flags()) | JSON_DECODE_ANY;
+  }
+
+  bool process();
+  bool deliver(size_t start, size_t end);
+  void compact();
+};
+
+} // namespace json
+
+#endif // JSONAPI_JSON_JSONINCREMENTALPARSER_HPP
@@ -0,0 +1,149 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#ifndef JSONAPI_JSON_JSONLAZYVALUE_HPP
+#define JSONAPI_JSON_JSONLAZYVALUE_HPP
+
+#include <memory>
+#include <unordered_map>
+
+#include <fs/File.hpp>
+#include <var/Data.hpp>
+#include <var/StringView.hpp>
+#include <var/Vector.hpp>
+
+#include "Json.hpp"
+
+namespace json {
+
+class JsonLazyValue;
+
+class JsonLazyIterator {
+public:
+  JsonLazyIterator() = default;
+  JsonLazyIterator(const JsonLazyValue *value, size_t index)
+    : m_value(value), m_index(index) {}
+
+  bool operator!=(JsonLazyIterator const &a) const noexcept {
+    return m_index != a.m_index;
+  }
+
+  JsonLazyValue operator*() const noexcept;
+
+  JsonLazyIterator &operator++() {
+    m_index++;
+    return *this;
+  }
+
+private:
+  const JsonLazyValue *m_value = nullptr;
+  size_t m_index = 0;
+};
+
+/*
+ * A value in JSON text that hasn't been parsed. The members of an object or
+ * array are indexed (byte offsets only) the first time they are accessed and
+ * nothing is decoded until to_value() is called. Values refer to the text
+ * owned by a JsonLazyDocument and must not outlive it.
+ *
+ * Values found from the same root share one table of indexed containers, so
+ * walking root.at("a").at("b") again doesn't scan "a" a second time. The
+ * table keeps every container that was visited until the last value from
+ * that root is gone.
+ *
+ * JsonLazyDocument document;
+ * document.load(fs::File("large.json"));
+ * const int id = document.root().find("items/[2]/id").to_value().to_integer();
+ *
+ */
+class JsonLazyValue : public api::ExecutionContext {
+public:
+  using Type = JsonValue::Type;
+
+  JsonLazyValue() = default;
+  explicit JsonLazyValue(const var::StringView json);
+
+  bool is_valid() const { return m_json.length() > 0; }
+
+  Type type() const;
+
+  bool is_object() const { return type() == Type::object; }
+  bool is_array() const { return type() == Type::array; }
+  bool is_string() const { return type() == Type::string; }
+  bool is_real() const { return type() == Type::real; }
+  bool is_integer() const { return type() == Type::integer; }
+  bool is_true() const { return type() == Type::true_; }
+  bool is_false() const { return type() == Type::false_; }
+  bool is_null() const { return type() == Type::null; }
+
+  // number of members of an object or array
+  size_t count() const;
+
+  JsonLazyValue at(const var::StringView key) const;
+  JsonLazyValue at(size_t position) const;
+
+  // key of the member at position (as written, escapes are not decoded)
+  var::StringView key_at(size_t position) const;
+
+  // same path syntax as JsonValue::find()
+  JsonLazyValue
+  find(const var::StringView path, const char *delimiter = "/") const;
+
+  JsonLazyIterator begin() const noexcept { return JsonLazyIterator(this, 0); }
+  JsonLazyIterator end() const noexcept {
+    return JsonLazyIterator(this, count());
+  }
+
+  // parses this value and all of its children
+  JsonValue to_value() const;
+
+  // the text of this value
+  var::StringView json() const { return m_json; }
+
+private:
+  struct Member {
+    size_t key_offset;
+    size_t key_length;
+    size_t value_offset;
+    size_t value_length;
+  };
+
+  // member lists by the address of the container's text
+  using MemberMap = std::unordered_map<const char *, var::Vector<Member>>;
+
+  var::StringView m_json;
+  // shared by the values found from the same root
+  std::shared_ptr<MemberMap> m_member_map;
+  mutable const var::Vector<Member> *m_member_list = nullptr;
+
+  const var::Vector<Member> &member_list() const;
+  JsonLazyValue member_value(const Member &member) const;
+};
+
+/*
+ * Owns the text used by JsonLazyValue. Loading the document only reads the
+ * text; values are found and parsed when they are accessed.
+ *
+ */
+class JsonLazyDocument : public api::ExecutionContext {
+public:
+  JsonLazyDocument() = default;
+
+  // values refer to the document's text
+  JsonLazyDocument(const JsonLazyDocument &) = delete;
+  JsonLazyDocument &operator=(const JsonLazyDocument &) = delete;
+  JsonLazyDocument(JsonLazyDocument &&) = default;
+  JsonLazyDocument &operator=(JsonLazyDocument &&) = default;
+
+  JsonLazyDocument &load(const fs::FileObject &file);
+  JsonLazyDocument &from_string(const var::StringView json);
+
+  const JsonLazyValue &root() const { return m_root; }
+
+private:
+  var::Data m_data;
+  JsonLazyValue m_root;
+};
+
+} // namespace json
+
+#endif // JSONAPI_JSON_JSONLAZYVALUE_HPP
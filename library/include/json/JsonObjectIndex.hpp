@@ -0,0 +1,58 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#ifndef JSONAPI_JSON_JSONOBJECTINDEX_HPP
+#define JSONAPI_JSON_JSONOBJECTINDEX_HPP
+
+#include <var/String.hpp>
+#include <var/Vector.hpp>
+
+#include "Json.hpp"
+
+namespace json {
+
+/*
+ * Member keys of an object in iteration order so at(size_t) and key_at()
+ * don't walk the object from the first key. Build the index once, then
+ * access members by position with one hashed lookup each.
+ *
+ * const JsonObjectIndex index(object);
+ * for (size_t i = 0; i < index.count(); i++) {
+ *   printf("%s\n", index.key_at(i).data());
+ * }
+ *
+ * The index holds a reference to the object and a copy of the keys, so
+ * changes made through other JsonValue copies are safe: at() returns an
+ * invalid value for a member that has been removed. Members inserted after
+ * the index is built aren't listed until it is rebuilt.
+ *
+ */
+class JsonObjectIndex {
+public:
+  JsonObjectIndex() = default;
+  explicit JsonObjectIndex(const JsonObject &object);
+
+  size_t count() const { return m_key_list.count(); }
+
+  // returns an invalid value if offset is past the end
+  JsonValue at(size_t offset) const;
+  var::StringView key_at(size_t offset) const;
+
+  const JsonObject &object() const { return m_object; }
+
+private:
+  // key in m_key_buffer
+  struct Key {
+    size_t offset;
+    size_t length;
+    // 0 if prehashed keys aren't supported
+    size_t hash;
+  };
+
+  JsonObject m_object;
+  var::String m_key_buffer;
+  var::Vector<Key> m_key_list;
+};
+
+} // namespace json
+
+#endif // JSONAPI_JSON_JSONOBJECTINDEX_HPP
@@ -0,0 +1,74 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#ifndef JSONAPI_JSON_JSONPATH_HPP
+#define JSONAPI_JSON_JSONPATH_HPP
+
+#include <api/api.hpp>
+
+#include <var/String.hpp>
+#include <var/StringView.hpp>
+#include <var/Vector.hpp>
+
+namespace json {
+
+/*
+ * A path for JsonValue::find() and JsonValue::lookup() that is split and
+ * parsed once. Evaluating it doesn't allocate, so the same paths can be
+ * checked against every incoming message.
+ *
+ * const JsonPath path("status/list/[2]/name");
+ * const auto name = message.find(path);
+ *
+ * Items are keys, [n] for array offsets and {n} for the nth member of an
+ * object. A leading delimiter is ignored. Each key is hashed once here, so
+ * objects are searched without hashing it again.
+ *
+ */
+class JsonPath {
+public:
+  enum class Type { key, array_offset, object_offset };
+
+  class Step {
+  public:
+    bool is_offset() const { return m_is_offset; }
+
+  private:
+    friend class JsonPath;
+    API_AF(Step, Type, type, Type::key);
+    // [n], {n} or a key that is all digits
+    API_AF(Step, size_t, offset, 0);
+    API_AF(Step, size_t, key_offset, 0);
+    API_AF(Step, size_t, key_length, 0);
+    // 0 if prehashed keys aren't supported
+    API_AF(Step, size_t, key_hash, 0);
+    bool m_is_offset = false;
+  };
+
+  JsonPath() = default;
+  explicit JsonPath(const var::StringView path, const char *delimiter = "/");
+
+  // false if the path has an empty item
+  bool is_valid() const { return m_is_valid; }
+
+  const var::String &path() const { return m_path; }
+  size_t count() const { return m_step_list.count(); }
+  const Step &at(size_t offset) const { return m_step_list.at(offset); }
+
+  // the item as written, including brackets
+  var::StringView key(const Step &step) const {
+    return var::StringView(
+      m_path.cstring() + step.key_offset(),
+      step.key_length());
+  }
+
+  const var::Vector<Step> &step_list() const { return m_step_list; }
+
+private:
+  var::String m_path;
+  var::Vector<Step> m_step_list;
+  bool m_is_valid = false;
+};
+
+} // namespace json
+
+#endif // JSONAPI_JSON_JSONPATH_HPP
@@ -0,0 +1,89 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#ifndef JSONAPI_JSON_JSONPOINTER_HPP
+#define JSONAPI_JSON_JSONPOINTER_HPP
+
+#include <var/String.hpp>
+#include <var/StringView.hpp>
+#include <var/Vector.hpp>
+
+#include "Json.hpp"
+
+namespace json {
+
+/*
+ * RFC 6901 JSON Pointer. The pointer is split and unescaped (~1 is /, ~0 is
+ * ~) once and can then be used on any number of values.
+ *
+ * const JsonPointer pointer("/devices/0/name");
+ * JsonValue name = pointer.get(root);
+ * pointer.set(root, JsonString("sensor"));
+ *
+ * "" is the root value and "-" is the element after the end of an array.
+ *
+ */
+class JsonPointer : public api::ExecutionContext {
+public:
+  class Token {
+  public:
+    // the token is an array index: 0 or digits without a leading zero
+    bool is_index() const { return m_is_index; }
+    // the token is "-"
+    bool is_end() const { return m_is_end; }
+
+  private:
+    friend class JsonPointer;
+    API_AF(Token, size_t, index, 0);
+    API_AF(Token, size_t, offset, 0);
+    API_AF(Token, size_t, length, 0);
+    bool m_is_index = false;
+    bool m_is_end = false;
+  };
+
+  JsonPointer() = default;
+  explicit JsonPointer(const var::StringView pointer);
+
+  // false if the pointer doesn't start with / or has a bad ~ escape
+  bool is_valid() const { return m_is_valid; }
+
+  const var::String &pointer() const { return m_pointer; }
+
+  size_t count() const { return m_token_list.count(); }
+  const Token &at(size_t offset) const { return m_token_list.at(offset); }
+
+  // unescaped token
+  var::StringView token(size_t offset) const {
+    const auto &value = m_token_list.at(offset);
+    return var::StringView(
+      m_token_string.cstring() + value.offset(),
+      value.length());
+  }
+
+  // returns an invalid value if nothing is at the pointer
+  JsonValue get(const JsonValue &root) const;
+
+  // creates missing objects and arrays along the pointer and a null at the
+  // end if needed
+  JsonValue create(JsonValue &root) const;
+
+  // creates missing objects and arrays then inserts, replaces or appends
+  // value
+  const JsonPointer &set(JsonValue &root, const JsonValue &value) const;
+
+  // escapes ~ and / so value can be used as one token
+  static var::String escape(const var::StringView value);
+
+private:
+  var::String m_pointer;
+  // unescaped tokens one after another
+  var::String m_token_string;
+  var::Vector<Token> m_token_list;
+  bool m_is_valid = false;
+
+  enum class IsCreate { no, yes };
+  json_t *resolve(json_t *root, size_t count, IsCreate is_create) const;
+};
+
+} // namespace json
+
+#endif // JSONAPI_JSON_JSONPOINTER_HPP
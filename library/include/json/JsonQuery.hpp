@@ -0,0 +1,129 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#ifndef JSONAPI_JSON_JSONQUERY_HPP
+#define JSONAPI_JSON_JSONQUERY_HPP
+
+#include <var/String.hpp>
+#include <var/StringView.hpp>
+#include <var/Vector.hpp>
+
+#include "Json.hpp"
+
+namespace json {
+
+/*
+ * JSONPath queries that are parsed once and evaluated without recursion.
+ *
+ * const JsonQuery query("$.devices[?(@.status == 'up')].id");
+ * for (const auto &id : query.find(root)) { ... }
+ *
+ * Supported:
+ *
+ * - $ (root), .key, ['key'], .* and [*]
+ * - ..key, ..* and ..[...] (recursive descent)
+ * - [n] and [-n] array offsets
+ * - [start:end:step] slices
+ * - [?(...)] filters on @ or @.key.key using ==, !=, <, <=, >, >= with
+ *   numbers, 'strings', true, false and null; @.key alone tests that key
+ *   exists; conditions are joined with && and ||
+ *
+ */
+class JsonQuery : public api::ExecutionContext {
+public:
+  // value is borrowed from the document being queried, return false to stop
+  using Callback = bool (*)(JsonRef value, void *context);
+
+  JsonQuery() = default;
+  explicit JsonQuery(const var::StringView query);
+
+  bool is_valid() const { return m_is_valid; }
+  const var::String &query() const { return m_query; }
+
+  // results in document order
+  var::Vector<JsonValue> find(const JsonValue &root) const;
+
+  // calls callback for each result without taking a reference, returns the
+  // number of results visited
+  size_t
+  for_each(const JsonValue &root, Callback callback, void *context) const;
+
+private:
+  enum class Type { key, wildcard, offset, slice, filter };
+
+  // offset and length in m_query
+  struct Span {
+    size_t offset;
+    size_t length;
+  };
+
+  struct Step {
+    Type type;
+    bool is_descendant;
+    Span key;
+    long start;
+    long end;
+    long step;
+    bool is_start;
+    bool is_end;
+    // filter conditions in m_condition_list
+    size_t condition_offset;
+    size_t condition_count;
+  };
+
+  enum class Operation {
+    exists,
+    equal,
+    not_equal,
+    less,
+    less_equal,
+    greater,
+    greater_equal
+  };
+  enum class Literal { number, string, true_, false_, null };
+
+  struct Condition {
+    // keys after @ in m_key_list
+    size_t key_offset;
+    size_t key_count;
+    Operation operation;
+    Literal literal;
+    double number;
+    Span string;
+    // the next condition is joined with || instead of &&
+    bool is_or;
+  };
+
+  struct Frame {
+    json_t *value;
+    size_t step;
+  };
+
+  var::String m_query;
+  var::Vector<Step> m_step_list;
+  var::Vector<Condition> m_condition_list;
+  var::Vector<Span> m_key_list;
+  bool m_is_valid = false;
+
+  var::StringView span(const Span &value) const {
+    return var::StringView(m_query.cstring() + value.offset, value.length);
+  }
+
+  bool parse();
+  bool parse_bracket(const char *&cursor, const char *end, Step &step);
+  bool parse_filter(const char *&cursor, const char *end, Step &step);
+  bool parse_condition(const char *&cursor, const char *end);
+
+  bool is_match(const Step &step, json_t *value) const;
+  bool is_match(const Condition &condition, json_t *value) const;
+  bool is_selected(
+    const Step &step,
+    const char *key,
+    size_t index,
+    size_t size,
+    json_t *value) const;
+  void expand(const Frame &frame, var::Vector<Frame> &scratch) const;
+};
+
+} // namespace json
+
+#endif // JSONAPI_JSON_JSONQUERY_HPP
@@ -0,0 +1,82 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#ifndef JSONAPI_JSON_JSONREADER_HPP
+#define JSONAPI_JSON_JSONREADER_HPP
+
+#include <fs/File.hpp>
+#include <var/StringView.hpp>
+
+#include "Json.hpp"
+
+namespace json {
+
+/*
+ * Event (SAX-style) parser. Values are delivered to a Handler as they are
+ * scanned and no JsonValue tree is created. Memory use is proportional to the
+ * nesting depth and the longest string, not to the size of the document.
+ *
+ */
+class JsonReader : public api::ExecutionContext {
+public:
+  enum class Flags {
+    null = 0x00,
+    // stop after the first complete value (see JsonDocument::Flags)
+    disable_eof_check = 0x01
+  };
+
+  class Handler {
+  public:
+    virtual ~Handler() = default;
+
+    // return false from any event to stop parsing (not an error)
+    virtual bool null() { return true; }
+    virtual bool boolean(bool value) { return true; }
+    virtual bool integer(s64 value) { return true; }
+    virtual bool real(double value) { return true; }
+    virtual bool string(const var::StringView value) { return true; }
+
+    virtual bool start_object() { return true; }
+    virtual bool key(const var::StringView key) { return true; }
+    virtual bool end_object(size_t count) { return true; }
+
+    virtual bool start_array() { return true; }
+    virtual bool end_array(size_t count) { return true; }
+  };
+
+  JsonReader &set_flags(Flags flags) {
+    m_flags = flags;
+    return *this;
+  }
+
+  Flags option_flags() const { return m_flags; }
+
+  JsonReader &set_buffer_size(size_t value) {
+    m_buffer_size = value;
+    return *this;
+  }
+
+  size_t buffer_size() const { return m_buffer_size; }
+
+  JsonReader &parse(const var::StringView json, Handler &handler);
+  JsonReader &parse(const fs::FileObject &file, Handler &handler);
+
+  // number of input bytes consumed by the last parse()
+  size_t position() const { return m_position; }
+
+  const JsonError &error() const { return m_error; }
+
+private:
+  Flags m_flags = Flags::null;
+  size_t m_buffer_size = 512;
+  size_t m_position = 0;
+  JsonError m_error;
+
+  JsonReader &
+  update_error(int code, size_t offset, const char *text, const char *source);
+};
+
+API_OR_NAMED_FLAGS_OPERATOR(JsonReader, Flags)
+
+} // namespace json
+
+#endif // JSONAPI_JSON_JSONREADER_HPP
@@ -0,0 +1,75 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#ifndef JSONAPI_JSON_JSONSEEKINDEX_HPP
+#define JSONAPI_JSON_JSONSEEKINDEX_HPP
+
+#include <fs/File.hpp>
+#include <var/String.hpp>
+#include <var/StringView.hpp>
+#include <var/Vector.hpp>
+
+#include "Json.hpp"
+
+namespace json {
+
+/*
+ * Offsets of the objects and arrays in a file, built in one pass. Paths use
+ * the JsonDocument::seek() syntax ("/", "/config", "/list/[3]"). The index
+ * can be saved next to the file and loaded later, then
+ * JsonDocument::seek(path, file, index) jumps to a container with a binary
+ * search instead of scanning the file.
+ *
+ * JsonSeekIndex index;
+ * index.set_maximum_depth(3).build(fs::File("archive.json"));
+ * index.save(fs::File(fs::File::IsOverwrite::yes, "archive.json.index"));
+ *
+ */
+class JsonSeekIndex : public api::ExecutionContext {
+public:
+  class Entry {
+  public:
+    bool is_valid() const { return m_end > m_start; }
+    size_t size() const { return is_valid() ? m_end - m_start : 0; }
+
+  private:
+    API_AC(Entry, var::String, path);
+    // offset of the { or [
+    API_AF(Entry, size_t, start, 0);
+    // offset after the } or ]
+    API_AF(Entry, size_t, end, 0);
+  };
+
+  // containers deeper than this aren't indexed, 0 is the root
+  JsonSeekIndex &set_maximum_depth(size_t value) {
+    m_maximum_depth = value;
+    return *this;
+  }
+
+  size_t maximum_depth() const { return m_maximum_depth; }
+
+  JsonSeekIndex &build(const fs::FileObject &file);
+
+  // sidecar format, one entry per line after the header
+  const JsonSeekIndex &save(const fs::FileObject &file) const;
+  JsonSeekIndex &load(const fs::FileObject &file);
+
+  // returns an invalid entry if the path isn't indexed
+  Entry find(const var::StringView path) const;
+
+  const var::Vector<Entry> &entry_list() const { return m_entry_list; }
+
+  // size of the file when the index was built
+  size_t source_size() const { return m_source_size; }
+
+private:
+  size_t m_maximum_depth = 4;
+  size_t m_source_size = 0;
+  // sorted by path
+  var::Vector<Entry> m_entry_list;
+
+  void sort();
+};
+
+} // namespace json
+
+#endif // JSONAPI_JSON_JSONSEEKINDEX_HPP
@@ -0,0 +1,332 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#ifndef JSONAPI_JSON_JSONSTRUCT_HPP
+#define JSONAPI_JSON_JSONSTRUCT_HPP
+
+#include <limits>
+#include <type_traits>
+
+#include <fs/File.hpp>
+#include <var/String.hpp>
+#include <var/StringView.hpp>
+#include <var/Vector.hpp>
+
+#include "JsonReader.hpp"
+#include "JsonWriter.hpp"
+
+namespace json {
+
+/*
+ * Reads JSON text straight into plain structs and writes them back without
+ * creating any JsonValue (json_t) nodes. Fields are listed once with
+ * JSON_FIELDS() in the same namespace as the struct.
+ *
+ * struct Sample {
+ *   u32 id = 0;
+ *   float voltage = 0.0f;
+ *   var::String name;
+ *   var::Vector<s32> list;
+ * };
+ * JSON_FIELDS(Sample, id, voltage, name, list)
+ *
+ * Sample sample;
+ * JsonStruct().read(R"({"id":1,"voltage":3.3})", sample);
+ * JsonStruct().write(file, sample);
+ *
+ * Field types are bool, integers, float, double, var::String, var::Vector
+ * and other structs with JSON_FIELDS(). Keys that aren't fields and null
+ * values are skipped, and fields missing from the input keep their value. A
+ * null array element is read as T() so later elements keep their positions
+ * ([1,null,2] is {1, 0, 2}). A value of the wrong type (or an integer that
+ * doesn't fit) is an error.
+ *
+ * Other types can be supported by specializing json::JsonStructField.
+ *
+ */
+class JsonStruct : public api::ExecutionContext {
+public:
+  struct Binding;
+
+  // a value being read and how to read it
+  struct Target {
+    void *value;
+    const Binding *binding;
+  };
+
+  // functions that read events into one type, nullptr if the type doesn't
+  // accept the event
+  struct Binding {
+    bool (*boolean)(void *value, bool input);
+    bool (*integer)(void *value, s64 input);
+    bool (*real)(void *value, double input);
+    bool (*string)(void *value, const var::StringView input);
+    // objects: the target for key or false to skip the key
+    bool (*key)(void *value, const var::StringView key, Target &target);
+    // arrays: clears the value when the array starts
+    void (*start_array)(void *value);
+    // arrays: the target for the next element
+    bool (*element)(void *value, Target &target);
+  };
+
+  using Flags = JsonDocument::Flags;
+
+  JsonStruct &set_buffer_size(size_t value) {
+    m_reader.set_buffer_size(value);
+    return *this;
+  }
+
+  template <class T> JsonStruct &read(const var::StringView json, T &value);
+  template <class T>
+  JsonStruct &read(const fs::FileObject &file, T &value);
+
+  template <class T> JsonStruct &write(JsonWriter &writer, const T &value);
+  template <class T>
+  JsonStruct &write(
+    const fs::FileObject &file,
+    const T &value,
+    Flags flags = Flags::compact);
+
+  // number of input bytes consumed by the last read()
+  size_t position() const { return m_reader.position(); }
+
+  const JsonError &error() const { return m_reader.error(); }
+
+private:
+  JsonReader m_reader;
+
+  JsonStruct &read(const var::StringView json, const Target &target);
+  JsonStruct &read(const fs::FileObject &file, const Target &target);
+  JsonStruct &update_error(bool is_type_error);
+};
+
+// how one field type is read and written
+template <class T, class Enable = void> struct JsonStructField {
+  // structs with JSON_FIELDS()
+  static const JsonStruct::Binding *binding() {
+    static const JsonStruct::Binding result
+      = {nullptr, nullptr, nullptr, nullptr, key, nullptr, nullptr};
+    return &result;
+  }
+
+  static void write(JsonWriter &writer, const T &value) {
+    writer.begin_object();
+    json_visit_fields(value, [&](const char *name, const auto &field) {
+      using Field = typename std::decay<decltype(field)>::type;
+      writer.key(name);
+      JsonStructField<Field>::write(writer, field);
+      return true;
+    });
+    writer.end_object();
+  }
+
+private:
+  static bool
+  key(void *value, const var::StringView key, JsonStruct::Target &target) {
+    // the visit stops at the matching field
+    return !json_visit_fields(
+      *static_cast<T *>(value),
+      [&](const char *name, auto &field) {
+        using Field = typename std::decay<decltype(field)>::type;
+        if (key != var::StringView(name)) {
+          return true;
+        }
+        target = {&field, JsonStructField<Field>::binding()};
+        return false;
+      });
+  }
+};
+
+template <> struct JsonStructField<bool> {
+  static const JsonStruct::Binding *binding() {
+    static const JsonStruct::Binding result
+      = {boolean, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+    return &result;
+  }
+
+  static void write(JsonWriter &writer, bool value) { writer.boolean(value); }
+
+private:
+  static bool boolean(void *value, bool input) {
+    *static_cast<bool *>(value) = input;
+    return true;
+  }
+};
+
+template <class T>
+struct JsonStructField<
+  T,
+  typename std::enable_if<
+    std::is_integral<T>::value && !std::is_same<T, bool>::value>::type> {
+  static const JsonStruct::Binding *binding() {
+    static const JsonStruct::Binding result
+      = {nullptr, integer, nullptr, nullptr, nullptr, nullptr, nullptr};
+    return &result;
+  }
+
+  static void write(JsonWriter &writer, T value) {
+    writer.integer(static_cast<s64>(value));
+  }
+
+private:
+  static bool integer(void *value, s64 input) {
+    if (std::is_unsigned<T>::value) {
+      if (
+        input < 0
+        || static_cast<u64>(input) > std::numeric_limits<T>::max()) {
+        return false;
+      }
+    } else if (
+      input < static_cast<s64>(std::numeric_limits<T>::min())
+      || input > static_cast<s64>(std::numeric_limits<T>::max())) {
+      return false;
+    }
+    *static_cast<T *>(value) = static_cast<T>(input);
+    return true;
+  }
+};
+
+template <class T>
+struct JsonStructField<
+  T,
+  typename std::enable_if<std::is_floating_point<T>::value>::type> {
+  static const JsonStruct::Binding *binding() {
+    static const JsonStruct::Binding result
+      = {nullptr, integer, real, nullptr, nullptr, nullptr, nullptr};
+    return &result;
+  }
+
+  static void write(JsonWriter &writer, T value) { writer.real(value); }
+
+private:
+  static bool integer(void *value, s64 input) {
+    *static_cast<T *>(value) = static_cast<T>(input);
+    return true;
+  }
+
+  static bool real(void *value, double input) {
+    *static_cast<T *>(value) = static_cast<T>(input);
+    return true;
+  }
+};
+
+template <> struct JsonStructField<var::String> {
+  static const JsonStruct::Binding *binding() {
+    static const JsonStruct::Binding result
+      = {nullptr, nullptr, nullptr, string, nullptr, nullptr, nullptr};
+    return &result;
+  }
+
+  static void write(JsonWriter &writer, const var::String &value) {
+    writer.string(value.string_view());
+  }
+
+private:
+  static bool string(void *value, const var::StringView input) {
+    *static_cast<var::String *>(value) = var::String(input);
+    return true;
+  }
+};
+
+template <class T> struct JsonStructField<var::Vector<T>> {
+  static const JsonStruct::Binding *binding() {
+    static const JsonStruct::Binding result
+      = {nullptr, nullptr, nullptr, nullptr, nullptr, start_array, element};
+    return &result;
+  }
+
+  static void write(JsonWriter &writer, const var::Vector<T> &value) {
+    writer.begin_array();
+    for (const auto &item : value) {
+      JsonStructField<T>::write(writer, item);
+    }
+    writer.end_array();
+  }
+
+private:
+  static void start_array(void *value) {
+    static_cast<var::Vector<T> *>(value)->clear();
+  }
+
+  static bool element(void *value, JsonStruct::Target &target) {
+    auto &list = *static_cast<var::Vector<T> *>(value);
+    list.push_back(T());
+    target = {&list.back(), JsonStructField<T>::binding()};
+    return true;
+  }
+};
+
+template <class T>
+JsonStruct &JsonStruct::read(const var::StringView json, T &value) {
+  return read(json, Target{&value, JsonStructField<T>::binding()});
+}
+
+template <class T>
+JsonStruct &JsonStruct::read(const fs::FileObject &file, T &value) {
+  return read(file, Target{&value, JsonStructField<T>::binding()});
+}
+
+template <class T>
+JsonStruct &JsonStruct::write(JsonWriter &writer, const T &value) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  JsonStructField<T>::write(writer, value);
+  return *this;
+}
+
+template <class T>
+JsonStruct &
+JsonStruct::write(const fs::FileObject &file, const T &value, Flags flags) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  JsonWriter writer(file);
+  writer.set_flags(flags);
+  JsonStructField<T>::write(writer, value);
+  writer.flush();
+  return *this;
+}
+
+} // namespace json
+
+#define JSON_FIELDS_VISIT(f) visitor(#f, value.f) &&
+
+#define JSON_FIELDS_MAP_1(m, a) m(a)
+#define JSON_FIELDS_MAP_2(m, a, ...) m(a) JSON_FIELDS_MAP_1(m, __VA_ARGS__)
+#define JSON_FIELDS_MAP_3(m, a, ...) m(a) JSON_FIELDS_MAP_2(m, __VA_ARGS__)
+#define JSON_FIELDS_MAP_4(m, a, ...) m(a) JSON_FIELDS_MAP_3(m, __VA_ARGS__)
+#define JSON_FIELDS_MAP_5(m, a, ...) m(a) JSON_FIELDS_MAP_4(m, __VA_ARGS__)
+#define JSON_FIELDS_MAP_6(m, a, ...) m(a) JSON_FIELDS_MAP_5(m, __VA_ARGS__)
+#define JSON_FIELDS_MAP_7(m, a, ...) m(a) JSON_FIELDS_MAP_6(m, __VA_ARGS__)
+#define JSON_FIELDS_MAP_8(m, a, ...) m(a) JSON_FIELDS_MAP_7(m, __VA_ARGS__)
+#define JSON_FIELDS_MAP_9(m, a, ...) m(a) JSON_FIELDS_MAP_8(m, __VA_ARGS__)
+#define JSON_FIELDS_MAP_10(m, a, ...) m(a) JSON_FIELDS_MAP_9(m, __VA_ARGS__)
+#define JSON_FIELDS_MAP_11(m, a, ...) m(a) JSON_FIELDS_MAP_10(m, __VA_ARGS__)
+#define JSON_FIELDS_MAP_12(m, a, ...) m(a) JSON_FIELDS_MAP_11(m, __VA_ARGS__)
+#define JSON_FIELDS_MAP_13(m, a, ...) m(a) JSON_FIELDS_MAP_12(m, __VA_ARGS__)
+#define JSON_FIELDS_MAP_14(m, a, ...) m(a) JSON_FIELDS_MAP_13(m, __VA_ARGS__)
+#define JSON_FIELDS_MAP_15(m, a, ...) m(a) JSON_FIELDS_MAP_14(m, __VA_ARGS__)
+#define JSON_FIELDS_MAP_16(m, a, ...) m(a) JSON_FIELDS_MAP_15(m, __VA_ARGS__)
+
+#define JSON_FIELDS_COUNT_N(                                                   \
+  _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, n,    \
+  ...)                                                                         \
+  n
+#define JSON_FIELDS_COUNT(...)                                                 \
+  JSON_FIELDS_COUNT_N(                                                         \
+    __VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1)
+
+#define JSON_FIELDS_CONCAT_IMPL(a, b) a##b
+#define JSON_FIELDS_CONCAT(a, b) JSON_FIELDS_CONCAT_IMPL(a, b)
+#define JSON_FIELDS_MAP(m, ...)                                                \
+  JSON_FIELDS_CONCAT(JSON_FIELDS_MAP_, JSON_FIELDS_COUNT(__VA_ARGS__))         \
+  (m, __VA_ARGS__)
+
+// lists up to 16 fields of s for json::JsonStruct
+#define JSON_FIELDS(s, ...)                                                    \
+  template <class Visitor>                                                     \
+  bool json_visit_fields(s &value, Visitor &&visitor) {                        \
+    return JSON_FIELDS_MAP(JSON_FIELDS_VISIT, __VA_ARGS__) true;               \
+  }                                                                            \
+  template <class Visitor>                                                     \
+  bool json_visit_fields(const s &value, Visitor &&visitor) {                  \
+    return JSON_FIELDS_MAP(JSON_FIELDS_VISIT, __VA_ARGS__) true;               \
+  }
+
+#endif // JSONAPI_JSON_JSONSTRUCT_HPP
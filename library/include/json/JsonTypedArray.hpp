@@ -0,0 +1,153 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#ifndef JSONAPI_JSON_JSONTYPEDARRAY_HPP
+#define JSONAPI_JSON_JSONTYPEDARRAY_HPP
+
+#include <type_traits>
+
+#include <var/Vector.hpp>
+
+#include "JsonStruct.hpp"
+
+namespace json {
+
+/*
+ * Array of numbers stored as one contiguous var::Vector<T> instead of a
+ * jansson value per element (about 40 bytes or more each). It reads and
+ * writes normal JSON arrays.
+ *
+ * JsonTypedArray<float> waveform;
+ * waveform.read(file);
+ * for (const float sample : waveform) { ... }
+ * waveform.write(output_file);
+ *
+ * read() parses the text straight into the buffer and fails if an element
+ * isn't a number (or doesn't fit in T). to_array() creates a JsonArray when a
+ * JsonValue tree is needed. A JsonTypedArray can also be a JSON_FIELDS()
+ * field.
+ *
+ */
+template <typename T> class JsonTypedArray : public api::ExecutionContext {
+  static_assert(
+    std::is_arithmetic<T>::value && !std::is_same<T, bool>::value,
+    "JsonTypedArray needs an integer or floating point type");
+
+public:
+  using Flags = JsonDocument::Flags;
+
+  JsonTypedArray() = default;
+  explicit JsonTypedArray(const var::Vector<T> &list) : m_list(list) {}
+  explicit JsonTypedArray(const JsonArray &array) { from_array(array); }
+
+  bool is_empty() const { return m_list.count() == 0; }
+  size_t count() const { return m_list.count(); }
+  T at(size_t offset) const { return m_list.at(offset); }
+
+  JsonTypedArray &push_back(T value) {
+    m_list.push_back(value);
+    return *this;
+  }
+
+  const T *begin() const { return m_list.data(); }
+  const T *end() const { return m_list.data() + m_list.count(); }
+
+  const var::Vector<T> &list() const { return m_list; }
+  var::Vector<T> &list() { return m_list; }
+
+  JsonTypedArray &read(const var::StringView json) {
+    API_RETURN_VALUE_IF_ERROR(*this);
+    JsonStruct().read(json, m_list);
+    return *this;
+  }
+
+  JsonTypedArray &read(const fs::FileObject &file) {
+    API_RETURN_VALUE_IF_ERROR(*this);
+    JsonStruct().read(file, m_list);
+    return *this;
+  }
+
+  const JsonTypedArray &write(JsonWriter &writer) const {
+    JsonStruct().write(writer, m_list);
+    return *this;
+  }
+
+  const JsonTypedArray &
+  write(const fs::FileObject &file, Flags flags = Flags::compact) const {
+    JsonStruct().write(file, m_list, flags);
+    return *this;
+  }
+
+  // replaces the contents with the numbers in array, same rules as read()
+  JsonTypedArray &from_array(const JsonArray &array) {
+    API_RETURN_VALUE_IF_ERROR(*this);
+    const auto &api = JsonValue::api();
+    const auto *binding = JsonStructField<T>::binding();
+    const size_t size = api->array_size(array.m_value);
+    m_list.clear();
+    m_list.reserve(size);
+    for (size_t i = 0; i < size; i++) {
+      const json_t *value = api->array_get(array.m_value, i);
+      T item = T();
+      // integer types have no real binding
+      const bool is_converted
+        = json_is_integer(value)
+            ? binding->integer(&item, api->integer_value(value))
+            : json_is_real(value) && binding->real != nullptr
+                && binding->real(&item, api->real_value(value));
+      if (!is_converted) {
+        API_RETURN_VALUE_ASSIGN_ERROR(
+          *this,
+          "array element doesn't fit the type",
+          EINVAL);
+      }
+      m_list.push_back(item);
+    }
+    return *this;
+  }
+
+  // creates a jansson value for each element
+  JsonArray to_array() const {
+    JsonArray result;
+    const auto &api = JsonValue::api();
+    for (const T item : m_list) {
+      json_t *value = std::is_floating_point<T>::value
+                        ? api->create_real(item)
+                        : api->create_integer(static_cast<json_int_t>(item));
+      API_SYSTEM_CALL("", api->array_append(result.m_value, value));
+      // the array holds the reference
+      api->decref(value);
+    }
+    return result;
+  }
+
+private:
+  var::Vector<T> m_list;
+};
+
+template <class T> struct JsonStructField<JsonTypedArray<T>> {
+  static const JsonStruct::Binding *binding() {
+    static const JsonStruct::Binding result
+      = {nullptr, nullptr, nullptr, nullptr, nullptr, start_array, element};
+    return &result;
+  }
+
+  static void write(JsonWriter &writer, const JsonTypedArray<T> &value) {
+    JsonStructField<var::Vector<T>>::write(writer, value.list());
+  }
+
+private:
+  static void start_array(void *value) {
+    static_cast<JsonTypedArray<T> *>(value)->list().clear();
+  }
+
+  static bool element(void *value, JsonStruct::Target &target) {
+    auto &list = static_cast<JsonTypedArray<T> *>(value)->list();
+    list.push_back(T());
+    target = {&list.back(), JsonStructField<T>::binding()};
+    return true;
+  }
+};
+
+} // namespace json
+
+#endif // JSONAPI_JSON_JSONTYPEDARRAY_HPP
@@ -0,0 +1,102 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#ifndef JSONAPI_JSON_JSONWRITER_HPP
+#define JSONAPI_JSON_JSONWRITER_HPP
+
+#include <fs/File.hpp>
+#include <var/Data.hpp>
+#include <var/StringView.hpp>
+
+#include "JsonDocument.hpp"
+
+namespace json {
+
+/*
+ * Streaming writer. Values are formatted as they are added and written to
+ * the file through an internal buffer, so no JsonValue tree is needed. The
+ * output matches JsonDocument::save() for the same flags.
+ *
+ * JsonWriter(file)
+ *   .begin_object()
+ *   .key("name").string("JsonAPI")
+ *   .key("list").begin_array().integer(1).integer(2).end_array()
+ *   .end_object();
+ *
+ */
+class JsonWriter : public api::ExecutionContext {
+public:
+  using Flags = JsonDocument::Flags;
+
+  explicit JsonWriter(
+    const fs::FileObject &file,
+    size_t buffer_size = JsonDocument::default_write_buffer_size);
+  ~JsonWriter();
+
+  JsonWriter(const JsonWriter &) = delete;
+  JsonWriter &operator=(const JsonWriter &) = delete;
+
+  JsonWriter &set_flags(Flags flags) {
+    m_flags = flags;
+    return *this;
+  }
+
+  Flags option_flags() const { return m_flags; }
+
+  JsonWriter &begin_object();
+  JsonWriter &end_object();
+  JsonWriter &begin_array();
+  JsonWriter &end_array();
+
+  JsonWriter &key(const var::StringView key);
+
+  JsonWriter &string(const var::StringView value);
+  JsonWriter &integer(s64 value);
+  JsonWriter &real(double value);
+  JsonWriter &boolean(bool value);
+  JsonWriter &null();
+
+  // writes an existing value (and all of its children)
+  JsonWriter &value(const JsonValue &value);
+
+  // ends a JSON Lines record, the writer must use Flags::compact
+  JsonWriter &end_line();
+
+  JsonWriter &append_line(const JsonValue &value) {
+    return this->value(value).end_line();
+  }
+
+  // writes any buffered output to the file
+  JsonWriter &flush();
+
+  // number of open objects and arrays
+  size_t depth() const { return m_container_list.count(); }
+
+private:
+  struct Container {
+    bool is_object;
+    size_t count;
+  };
+
+  const fs::FileObject &m_file;
+  Flags m_flags = Flags::indent3;
+  var::Data m_buffer;
+  size_t m_buffer_offset = 0;
+  var::Vector<Container> m_container_list;
+  bool m_is_key_pending = false;
+
+  u32 json_flags() const { return static_cast<u32>(option_flags()); }
+  size_t indent() const { return json_flags() & JSON_MAX_INDENT; }
+
+  JsonWriter &begin_value();
+  JsonWriter &begin_container(bool is_object);
+  JsonWriter &end_container(bool is_object);
+
+  void write_indent(size_t depth, bool is_space);
+  void write_escaped(const var::StringView value);
+  void write(const var::StringView value);
+  void write(char c);
+};
+
+} // namespace json
+
+#endif // JSONAPI_JSON_JSONWRITER_HPP
@@ -6,18 +6,22 @@
 // full copy, no reference to original
 #define JSON_ACCESS_STRING_WITH_KEY(c, k, v)                                   \
   static const char *v##_key() { return MCU_STRINGIFY(k); }                    \
+  static const json::JsonKey &v##_json_key() {                                 \
+    static const auto result = json::JsonKey::literal(MCU_STRINGIFY(k));       \
+    return result;                                                             \
+  }                                                                            \
   const char *get_##v##_cstring() const {                                      \
-    return to_object().at(MCU_STRINGIFY(k)).to_cstring();                      \
+    return to_object().at(v##_json_key()).to_cstring();                        \
   }                                                                            \
   var::StringView get_##v() const {                                            \
-    return var::StringView(to_object().at(MCU_STRINGIFY(k)).to_string_view()); \
+    return var::StringView(to_object().at(v##_json_key()).to_string_view());   \
   }                                                                            \
   c &set_##v(const var::StringView value) {                                    \
-    to_object().insert(MCU_STRINGIFY(k), json::JsonString(value));             \
+    to_object().insert(v##_json_key(), json::JsonString(value));               \
     return *this;                                                              \
   }                                                                            \
   c &remove_##v() {                                                            \
-    to_object().remove(MCU_STRINGIFY(k));                                      \
+    to_object().remove(v##_json_key());                                        \
     return *this;                                                              \
   }                                                                            \
   void json_access_string_with_key_never_used_##v()
@@ -27,13 +31,17 @@
 // full copy, no reference to original
 #define JSON_ACCESS_BOOL_WITH_KEY(c, k, v)                                     \
   static const char *v##_key() { return MCU_STRINGIFY(k); }                    \
-  bool is_##v() const { return to_object().at(MCU_STRINGIFY(k)).to_bool(); }   \
+  static const json::JsonKey &v##_json_key() {                                 \
+    static const auto result = json::JsonKey::literal(MCU_STRINGIFY(k));       \
+    return result;                                                             \
+  }                                                                            \
+  bool is_##v() const { return to_object().at(v##_json_key()).to_bool(); }     \
   c &set_##v(bool value = true) {                                              \
-    to_object().insert_bool(MCU_STRINGIFY(k), value);                          \
+    to_object().insert_bool(v##_json_key(), value);                            \
     return *this;                                                              \
   }                                                                            \
   c &remove_##v() {                                                            \
-    to_object().remove(MCU_STRINGIFY(k));                                      \
+    to_object().remove(v##_json_key());                                        \
     return *this;                                                              \
   }                                                                            \
   void json_access_bool_with_key_never_used_##v()
@@ -43,15 +51,19 @@
 // full copy, no reference to original
 #define JSON_ACCESS_INTEGER_WITH_KEY(c, k, v)                                  \
   static const char *v##_key() { return MCU_STRINGIFY(k); }                    \
+  static const json::JsonKey &v##_json_key() {                                 \
+    static const auto result = json::JsonKey::literal(MCU_STRINGIFY(k));       \
+    return result;                                                             \
+  }                                                                            \
   s32 get_##v() const {                                                        \
-    return to_object().at(MCU_STRINGIFY(k)).to_integer();                      \
+    return to_object().at(v##_json_key()).to_integer();                        \
   }                                                                            \
   c &set_##v(s32 value) {                                                      \
-    to_object().insert(MCU_STRINGIFY(k), json::JsonInteger(value));            \
+    to_object().insert(v##_json_key(), json::JsonInteger(value));              \
     return *this;                                                              \
   }                                                                            \
   c &remove_##v() {                                                            \
-    to_object().remove(MCU_STRINGIFY(k));                                      \
+    to_object().remove(v##_json_key());                                        \
     return *this;                                                              \
   }                                                                            \
   void json_access_integer_with_key_never_used_##v()
@@ -59,13 +71,17 @@
 
 #define JSON_ACCESS_REAL_WITH_KEY(c, k, v)                                     \
   static const char *v##_key() { return MCU_STRINGIFY(k); }                    \
-  float get_##v() const { return to_object().at(MCU_STRINGIFY(k)).to_real(); } \
+  static const json::JsonKey &v##_json_key() {                                 \
+    static const auto result = json::JsonKey::literal(MCU_STRINGIFY(k));       \
+    return result;                                                             \
+  }                                                                            \
+  float get_##v() const { return to_object().at(v##_json_key()).to_real(); }   \
   c &set_##v(float value) {                                                    \
-    to_object().insert(MCU_STRINGIFY(k), json::JsonReal(value));               \
+    to_object().insert(v##_json_key(), json::JsonReal(value));                 \
     return *this;                                                              \
   }                                                                            \
   c &remove_##v() {                                                            \
-    to_object().remove(MCU_STRINGIFY(k));                                      \
+    to_object().remove(v##_json_key());                                        \
     return *this;                                                              \
   }                                                                            \
   void json_access_real_with_key_never_used_##v()
@@ -74,16 +90,20 @@
 // gets a copy that refers to the original JSON values
 #define JSON_ACCESS_OBJECT_WITH_KEY(c, T, k, v)                                \
   static const char *v##_key() { return MCU_STRINGIFY(k); }                    \
-  T v() const { return T(to_object().at(MCU_STRINGIFY(k))); }                  \
+  static const json::JsonKey &v##_json_key() {                                 \
+    static const auto result = json::JsonKey::literal(MCU_STRINGIFY(k));       \
+    return result;                                                             \
+  }                                                                            \
+  T v() const { return T(to_object().at(v##_json_key())); }                    \
   T get_##v() const {                                                          \
-    return T(json::JsonObject().copy(to_object().at(MCU_STRINGIFY(k))));       \
+    return T(json::JsonObject().copy(to_object().at(v##_json_key())));         \
   }                                                                            \
   c &set_##v(const T &a) {                                                     \
-    to_object().insert(MCU_STRINGIFY(k), a);                                   \
+    to_object().insert(v##_json_key(), a);                                     \
     return *this;                                                              \
   }                                                                            \
   c &remove_##v() {                                                            \
-    to_object().remove(MCU_STRINGIFY(k));                                      \
+    to_object().remove(v##_json_key());                                        \
     return *this;                                                              \
   }                                                                            \
   void json_access_object_with_key_never_used_##v()
@@ -94,27 +114,31 @@
 // get) T should have JsonKeyValue as a base
 #define JSON_ACCESS_OBJECT_LIST_WITH_KEY(c, T, k, v)                           \
   static const char *v##_key() { return MCU_STRINGIFY(k); }                    \
+  static const json::JsonKey &v##_json_key() {                                 \
+    static const auto result = json::JsonKey::literal(MCU_STRINGIFY(k));       \
+    return result;                                                             \
+  }                                                                            \
   json::JsonObject v##_to_object() const {                                     \
-    return to_object().at(MCU_STRINGIFY(k));                                   \
+    return to_object().at(v##_json_key());                                     \
   }                                                                            \
   json::JsonKeyValueList<T> get_##v() const {                                  \
     return to_object()                                                         \
-      .at(MCU_STRINGIFY(k))                                                    \
+      .at(v##_json_key())                                                      \
       .to_object()                                                             \
       .construct_key_list_copy<T>();                                           \
   }                                                                            \
   json::JsonKeyValueList<T> v() const {                                        \
     return to_object()                                                         \
-      .at(MCU_STRINGIFY(k))                                                    \
+      .at(v##_json_key())                                                      \
       .to_object()                                                             \
       .construct_key_list<T>();                                                \
   }                                                                            \
   c &set_##v(const json::JsonKeyValueList<T> &a) {                             \
-    to_object().insert(MCU_STRINGIFY(k), json::JsonObject(a));                 \
+    to_object().insert(v##_json_key(), json::JsonObject(a));                   \
     return *this;                                                              \
   }                                                                            \
   c &remove_##v() {                                                            \
-    to_object().remove(MCU_STRINGIFY(k));                                      \
+    to_object().remove(v##_json_key());                                        \
     return *this;                                                              \
   }                                                                            \
   void json_access_object_list_never_used_##v()
@@ -126,24 +150,28 @@
 // get)
 #define JSON_ACCESS_ARRAY_WITH_KEY(c, T, k, v)                                 \
   static const char *v##_key() { return MCU_STRINGIFY(k); }                    \
+  static const json::JsonKey &v##_json_key() {                                 \
+    static const auto result = json::JsonKey::literal(MCU_STRINGIFY(k));       \
+    return result;                                                             \
+  }                                                                            \
   json::JsonArray v##_to_array() const {                                       \
-    return to_object().at(MCU_STRINGIFY(k));                                   \
+    return to_object().at(v##_json_key());                                     \
   }                                                                            \
   var::Vector<T> get_##v() const {                                             \
     return to_object()                                                         \
-      .at(MCU_STRINGIFY(k))                                                    \
+      .at(v##_json_key())                                                      \
       .to_array()                                                              \
       .construct_list_copy<T>();                                               \
   }                                                                            \
   var::Vector<T> v() const {                                                   \
-    return to_object().at(MCU_STRINGIFY(k)).to_array().construct_list<T>();    \
+    return to_object().at(v##_json_key()).to_array().construct_list<T>();      \
   }                                                                            \
   c &set_##v(const var::Vector<T> &a) {                                        \
-    to_object().insert(MCU_STRINGIFY(k), json::JsonArray(a));                  \
+    to_object().insert(v##_json_key(), json::JsonArray(a));                    \
     return *this;                                                              \
   }                                                                            \
   c &remove_##v() {                                                            \
-    to_object().remove(MCU_STRINGIFY(k));                                      \
+    to_object().remove(v##_json_key());                                        \
     return *this;                                                              \
   }                                                                            \
   void json_access_array_with_key_never_used_##v()
@@ -153,14 +181,18 @@
 // gets a copy that refers to the original JSON values
 #define JSON_ACCESS_VALUE_WITH_KEY(c, k, v)                                    \
   static const char *v##_key() { return MCU_STRINGIFY(k); }                    \
+  static const json::JsonKey &v##_json_key() {                                 \
+    static const auto result = json::JsonKey::literal(MCU_STRINGIFY(k));       \
+    return result;                                                             \
+  }                                                                            \
   const json::JsonValue v() const {                                           \
-    return to_object().at(MCU_STRINGIFY(k));                                   \
+    return to_object().at(v##_json_key());                                     \
   }                                                                            \
   json::JsonValue get_##v() const {                                            \
-    return json::JsonValue().copy(to_object().at(MCU_STRINGIFY(k)));           \
+    return json::JsonValue().copy(to_object().at(v##_json_key()));             \
   }                                                                            \
   c &set_##v(const json::JsonValue &a) {                                       \
-    to_object().insert(MCU_STRINGIFY(k), a);                                   \
+    to_object().insert(v##_json_key(), a);                                     \
     return *this;                                                              \
   }                                                                            \
   void json_access_value_with_key_never_used_##v()
@@ -170,19 +202,23 @@
 // full copy, no reference to original
 #define JSON_ACCESS_STRING_ARRAY_WITH_KEY(c, k, v)                             \
   static const char *v##_key() { return MCU_STRINGIFY(k); }                    \
+  static const json::JsonKey &v##_json_key() {                                 \
+    static const auto result = json::JsonKey::literal(MCU_STRINGIFY(k));       \
+    return result;                                                             \
+  }                                                                            \
   var::StringViewList get_##v() const {                                        \
-    return to_object().at(MCU_STRINGIFY(k)).to_array().string_view_list();     \
+    return to_object().at(v##_json_key()).to_array().string_view_list();       \
   }                                                                            \
   c &set_##v(const var::StringViewList &a) {                                   \
-    to_object().insert(MCU_STRINGIFY(k), json::JsonArray(a));                  \
+    to_object().insert(v##_json_key(), json::JsonArray(a));                    \
     return *this;                                                              \
   }                                                                            \
   c &set_##v(const var::StringList &a) {                                       \
-    to_object().insert(MCU_STRINGIFY(k), json::JsonArray(a));                  \
+    to_object().insert(v##_json_key(), json::JsonArray(a));                    \
     return *this;                                                              \
   }                                                                            \
   c &remove_##v() {                                                            \
-    to_object().remove(MCU_STRINGIFY(k));                                      \
+    to_object().remove(v##_json_key());                                        \
     return *this;                                                              \
   }                                                                            \
   void json_access_array_with_key_never_used_##v()
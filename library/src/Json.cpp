@@ -1,5 +1,6 @@
 // Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
 
+#include <limits>
 #include <type_traits>
 
 #if USE_PRINTER
@@ -13,6 +14,7 @@
 #include <var/Tokenizer.hpp>
 
 #include "json/Json.hpp"
+#include "json/JsonPath.hpp"
 
 printer::Printer &
 printer::operator<<(Printer &printer, const json::JsonValue &a) {
@@ -163,23 +165,44 @@ JsonValue::~JsonValue() {
   }
 }
 
+namespace {
+
+json_t *object_value(
+  const json_t *value,
+  const JsonPath &path,
+  const JsonPath::Step &step) {
+  const auto key = path.key(step);
+  if (JsonValue::is_prehashed_key_supported()) {
+    return JsonValue::api()->object_getn_hashed(
+      value,
+      key.data(),
+      key.length(),
+      step.key_hash());
+  }
+  return JsonValue::api()->object_getn(value, key.data(), key.length());
+}
+
+} // namespace
+
 JsonValue JsonValue::lookup(const var::StringView key_path) const {
   API_ASSERT(key_path.at(0) == '/');
-  const auto element_list = key_path.split("/");
+  return lookup(JsonPath(key_path));
+}
 
-  JsonValue parent = *this;
-  for (size_t i = 1; i < element_list.count(); i++) {
-    const auto element = element_list.at(i);
-    // first element is empty
-    JsonValue child
-      = parent.is_object()
-          ? parent.to_object().at(element)
-          : (
-            parent.is_array() ? parent.to_array().at(element.to_integer())
-                              : parent);
-    parent = child;
+JsonValue JsonValue::lookup(const JsonPath &path) const {
+  if (path.is_valid() == false) {
+    return JsonValue();
   }
-  return parent;
+
+  json_t *current = m_value;
+  for (const auto &step : path.step_list()) {
+    if (json_is_object(current)) {
+      current = object_value(current, path, step);
+    } else if (json_is_array(current)) {
+      current = api()->array_get(current, step.offset());
+    }
+  }
+  return JsonValue(current);
 }
 
 const JsonObject &JsonValue::to_object() const {
@@ -187,9 +210,7 @@ const JsonObject &JsonValue::to_object() const {
 }
 
 JsonValue JsonObjectIterator::operator*() const noexcept {
-  return JsonValue(m_json_value)
-    .to_object()
-    .at(api()->object_iter_key(m_json_iter));
+  return JsonValue(api()->object_iter_value(m_json_iter));
 }
 
 JsonObject &JsonValue::to_object() { return static_cast<JsonObject &>(*this); }
@@ -247,26 +268,96 @@ JsonValue &JsonValue::copy(const JsonValue &value, IsDeepCopy is_deep) {
   return *this;
 }
 
-const char *JsonValue::to_cstring() const {
-  const char *result;
-  if (is_string()) {
-    result = api()->string_value(m_value);
-  } else if (is_true()) {
-    result = "true";
-  } else if (is_false()) {
-    result = "false";
-  } else if (is_null()) {
-    result = "null";
-  } else if (is_object()) {
-    result = "{object}";
-  } else if (is_array()) {
-    result = "[array]";
-  } else {
-    result = "";
+namespace {
+
+// conversions shared by JsonValue and the JsonArray bulk copies
+
+JsonValue::Type value_type(const json_t *value) {
+  return value ? static_cast<JsonValue::Type>(json_typeof(value))
+               : JsonValue::Type::invalid;
+}
+
+const char *cstring_value(const json_t *value) {
+  switch (value_type(value)) {
+  case JsonValue::Type::string:
+    return JsonValue::api()->string_value(value);
+  case JsonValue::Type::true_:
+    return "true";
+  case JsonValue::Type::false_:
+    return "false";
+  case JsonValue::Type::null:
+    return "null";
+  case JsonValue::Type::object:
+    return "{object}";
+  case JsonValue::Type::array:
+    return "[array]";
+  default:
+    return "";
   }
-  return result;
 }
 
+float real_value(const json_t *value) {
+  switch (value_type(value)) {
+  case JsonValue::Type::string:
+    return var::StringView(cstring_value(value)).to_float();
+  case JsonValue::Type::integer:
+    return JsonValue::api()->integer_value(value) * 1.0f;
+  case JsonValue::Type::real:
+    return JsonValue::api()->real_value(value);
+  case JsonValue::Type::true_:
+    return 1.0f;
+  default:
+    return 0.0f;
+  }
+}
+
+int integer_value(const json_t *value) {
+  switch (value_type(value)) {
+  case JsonValue::Type::string:
+    return var::StringView(cstring_value(value)).to_integer();
+  case JsonValue::Type::real:
+    return real_value(value);
+  case JsonValue::Type::integer:
+    return JsonValue::api()->integer_value(value);
+  case JsonValue::Type::true_:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+bool bool_value(const json_t *value) {
+  switch (value_type(value)) {
+  case JsonValue::Type::true_:
+  case JsonValue::Type::object:
+  case JsonValue::Type::array:
+    return true;
+  case JsonValue::Type::string:
+    return cstring_value(value) == var::StringView("true");
+  case JsonValue::Type::integer:
+    return integer_value(value) != 0;
+  case JsonValue::Type::real:
+    return real_value(value) != 0.0f;
+  default:
+    return false;
+  }
+}
+
+json_t *object_value(const json_t *value, const JsonKey &key) {
+  if (JsonValue::is_prehashed_key_supported()) {
+    return JsonValue::api()->object_getn_hashed(
+      value,
+      key.cstring(),
+      key.length(),
+      key.hash());
+  }
+  return JsonValue::api()->object_getn(value, key.cstring(), key.length());
+}
+
+} // namespace
+
+const char *JsonValue::to_cstring() const { return cstring_value(m_value); }
+
 var::String JsonValue::to_string() const {
   var::String result;
   if (is_string()) {
@@ -291,73 +382,87 @@ var::String JsonValue::to_string() const {
   return result;
 }
 
-float JsonValue::to_real() const {
-  if (is_string()) {
-    return to_string_view().to_float();
-  } else if (is_integer()) {
-    return to_integer() * 1.0f;
-  } else if (is_real()) {
-    return api()->real_value(m_value);
-  } else if (is_true()) {
-    return 1.0f;
-  }
+float JsonValue::to_real() const { return real_value(m_value); }
 
-  return 0.0f;
-}
+int JsonValue::to_integer() const { return integer_value(m_value); }
 
-int JsonValue::to_integer() const {
-  if (is_string()) {
-    return to_string_view().to_integer();
-  } else if (is_real()) {
-    return to_real();
-  } else if (is_integer()) {
-    return api()->integer_value(m_value);
-  }
+bool JsonValue::to_bool() const { return bool_value(m_value); }
 
-  if (is_true()) {
-    return 1;
-  }
+JsonRef JsonValue::view() const { return JsonRef(m_value); }
 
-  if (is_false()) {
-    return 0;
+const char *JsonRef::to_cstring() const { return cstring_value(m_value); }
+
+float JsonRef::to_real() const { return real_value(m_value); }
+
+int JsonRef::to_integer() const { return integer_value(m_value); }
+
+bool JsonRef::to_bool() const { return bool_value(m_value); }
+
+size_t JsonRef::count() const {
+  if (is_object()) {
+    return JsonValue::api()->object_size(m_value);
   }
-  if (is_null()) {
-    return 0;
+  if (is_array()) {
+    return JsonValue::api()->array_size(m_value);
   }
-
   return 0;
 }
 
-bool JsonValue::to_bool() const {
-  if (is_true()) {
-    return true;
-  }
-  if (is_false()) {
-    return false;
-  }
+JsonRef JsonRef::at(size_t offset) const {
+  return JsonRef(JsonValue::api()->array_get(m_value, offset));
+}
 
-  if (is_string()) {
-    if (to_cstring() == var::StringView("true")) {
-      return true;
-    }
-    return false;
-  }
+JsonRef JsonRef::at(const var::StringView key) const {
+  return JsonRef(
+    JsonValue::api()->object_getn(m_value, key.data(), key.length()));
+}
 
-  if (is_integer()) {
-    return to_integer() != 0;
+JsonRef JsonRef::at(const JsonKey &key) const {
+  return JsonRef(object_value(m_value, key));
+}
+
+JsonRefIterator JsonRef::begin() const {
+  if (is_object()) {
+    // jansson doesn't change the object to iterate it
+    return JsonRefIterator(
+      m_value,
+      0,
+      JsonValue::api()->object_iter(const_cast<json_t *>(m_value)));
   }
-  if (is_real()) {
-    return to_real() != 0.0f;
+  return JsonRefIterator(m_value, 0, nullptr);
+}
+
+JsonRefIterator JsonRef::end() const {
+  return JsonRefIterator(m_value, is_array() ? count() : 0, nullptr);
+}
+
+JsonValue JsonRef::to_value() const {
+  return JsonValue(const_cast<json_t *>(m_value));
+}
+
+JsonRef JsonRefIterator::operator*() const noexcept {
+  if (m_json_iter) {
+    return JsonRef(JsonValue::api()->object_iter_value(m_json_iter));
   }
+  return JsonRef(JsonValue::api()->array_get(m_json_value, m_index));
+}
 
-  if (is_object()) {
-    return true;
+var::StringView JsonRefIterator::key() const noexcept {
+  if (m_json_iter == nullptr) {
+    return var::StringView();
   }
+  return JsonValue::api()->object_iter_key(m_json_iter);
+}
 
-  if (is_array()) {
-    return true;
+JsonRefIterator &JsonRefIterator::operator++() {
+  if (m_json_iter) {
+    m_json_iter = JsonValue::api()->object_iter_next(
+      const_cast<json_t *>(m_json_value),
+      m_json_iter);
+  } else {
+    m_index++;
   }
-  return false;
+  return *this;
 }
 
 JsonObject::JsonObject() { m_value = JsonObject::create(); }
@@ -412,6 +517,13 @@ JsonObject &JsonObject::insert_bool(const var::StringView key, bool value) {
   return insert(Key(key).cstring, JsonFalse());
 }
 
+JsonObject &JsonObject::insert_bool(const JsonKey &key, bool value) {
+  if (value) {
+    return insert(key, JsonTrue());
+  }
+  return insert(key, JsonFalse());
+}
+
 JsonObject &
 JsonObject::insert(const var::StringView key, const JsonValue &value) {
   if (create_if_not_valid(create) < 0) {
@@ -424,6 +536,26 @@ JsonObject::insert(const var::StringView key, const JsonValue &value) {
   return *this;
 }
 
+JsonObject &JsonObject::insert(const JsonKey &key, const JsonValue &value) {
+  if (is_prehashed_key_supported() == false) {
+    return insert(key.string_view(), value);
+  }
+
+  if (create_if_not_valid(create) < 0) {
+    return *this;
+  }
+
+  API_SYSTEM_CALL(
+    "",
+    api()->object_setn_hashed(
+      m_value,
+      key.cstring(),
+      key.length(),
+      key.hash(),
+      value.m_value));
+  return *this;
+}
+
 JsonObject &JsonObject::update(const JsonValue &value, UpdateFlags o_flags) {
   API_RETURN_VALUE_IF_ERROR(*this);
   if (o_flags & UpdateFlags::existing) {
@@ -451,6 +583,24 @@ JsonObject &JsonObject::remove(const var::StringView key) {
   return *this;
 }
 
+JsonObject &JsonObject::remove(const JsonKey &key) {
+  if (is_prehashed_key_supported() == false) {
+    return remove(key.string_view());
+  }
+
+  API_RETURN_VALUE_IF_ERROR(*this);
+  // jansson_api.c removes through json_object_deln(), which hashes the key
+  // again; only lookups and replacing a value skip the hash
+  API_SYSTEM_CALL(
+    "",
+    api()->object_deln_hashed(
+      m_value,
+      key.cstring(),
+      key.length(),
+      key.hash()));
+  return *this;
+}
+
 u32 JsonObject::count() const { return api()->object_size(m_value); }
 
 JsonObject &JsonObject::clear() {
@@ -482,88 +632,83 @@ JsonValue JsonObject::at(const var::StringView key) const {
   return JsonValue(api()->object_getn(m_value, key.data(), key.length()));
 }
 
+JsonValue JsonObject::at(const JsonKey &key) const {
+  return JsonValue(object_value(m_value, key));
+}
+
+JsonRef JsonObject::view_at(const var::StringView key) const {
+  return JsonRef(api()->object_getn(m_value, key.data(), key.length()));
+}
+
+JsonRef JsonObject::view_at(const JsonKey &key) const {
+  return JsonRef(object_value(m_value, key));
+}
+
+size_t JsonKey::hash() const {
+  // threads that race here compute and store the same value
+  size_t result = m_hash.load(std::memory_order_relaxed);
+  if (result == 0 && JsonValue::is_prehashed_key_supported()) {
+    result = JsonValue::api()->object_key_hash(cstring(), m_length);
+    m_hash.store(result, std::memory_order_relaxed);
+  }
+  return result;
+}
+
 JsonValue JsonObject::at(size_t offset) const {
-  size_t count = 0;
-  for (const auto &child : *this) {
-    if (count == offset) {
-      return child;
-    }
-    count++;
+  // use JsonObjectIndex to access many members by position
+  void *iter = api()->object_iter(m_value);
+  for (size_t i = 0; iter && i < offset; i++) {
+    iter = api()->object_iter_next(m_value, iter);
   }
-  return JsonValue();
+  return iter ? JsonValue(api()->object_iter_value(iter)) : JsonValue();
 }
 
 JsonValue
 JsonValue::find(const var::StringView path, const char *delimiter) const {
-  const auto list = path.split(delimiter);
-  JsonValue current = *this;
-
-  auto get_offset_from_string = [](var::StringView item) {
-    return item.pop_back().pop_back().to_unsigned_long();
-  };
-
-  for (const auto item : list) {
-    if (item.is_empty()) {
-      API_RETURN_VALUE_ASSIGN_ERROR(JsonValue(), "empty item provided", EINVAL);
-      return JsonValue();
-    }
+  return find(JsonPath(path, delimiter));
+}
 
-    if (current.is_object()) {
-      auto next = current.to_object().at(item);
-      if (next.is_valid()) {
-        current = next;
-        continue;
-      }
+JsonValue JsonValue::find(const JsonPath &path) const {
+  if (path.is_valid() == false) {
+    API_RETURN_VALUE_ASSIGN_ERROR(JsonValue(), "empty item provided", EINVAL);
+  }
 
-      if (item.at(0) == '{') {
-        const auto object_offset = get_offset_from_string(item);
-        size_t count = 0;
-        bool is_found = false;
-        for (const auto &value : current.to_object()) {
-          if (count == object_offset) {
-            current = value;
-            is_found = true;
-            break;
-          }
-          count++;
+  json_t *current = m_value;
+  for (const auto &step : path.step_list()) {
+    if (json_is_object(current)) {
+      json_t *next = object_value(current, path, step);
+      if (next == nullptr && step.type() == JsonPath::Type::object_offset) {
+        void *iter = api()->object_iter(current);
+        for (size_t i = 0; iter && i < step.offset(); i++) {
+          iter = api()->object_iter_next(current, iter);
         }
-        if (!is_found) {
+        if (iter == nullptr) {
           API_RETURN_VALUE_ASSIGN_ERROR(
             JsonValue(),
             "didn't find {} offset",
             EINVAL);
         }
-      } else {
-        current = current.to_object().at(item);
+        next = api()->object_iter_value(iter);
       }
-    } else if (current.is_array()) {
-      if (item.at(0) == '[') {
-        if (current.is_array() == false) {
-          API_RETURN_VALUE_ASSIGN_ERROR(JsonValue(), "not an array", EINVAL);
-        }
-        const auto array_offset = get_offset_from_string(item);
-        ;
-        if (current.to_array().count() <= array_offset) {
-          API_RETURN_VALUE_ASSIGN_ERROR(
-            JsonValue(),
-            "[] is beyond array",
-            EINVAL);
-        }
-        current = current.to_array().at(array_offset);
-      } else {
+      current = next;
+    } else if (json_is_array(current)) {
+      if (step.type() != JsonPath::Type::array_offset) {
         API_RETURN_VALUE_ASSIGN_ERROR(
           JsonValue(),
           "array not specified []",
           EINVAL);
-        return JsonValue();
       }
+      if (api()->array_size(current) <= step.offset()) {
+        API_RETURN_VALUE_ASSIGN_ERROR(JsonValue(), "[] is beyond array", EINVAL);
+      }
+      current = api()->array_get(current, step.offset());
     }
-    if (current.is_valid() == false) {
+
+    if (current == nullptr) {
       API_RETURN_VALUE_ASSIGN_ERROR(JsonValue(), "invalid path", EINVAL);
-      return JsonValue();
     }
   }
-  return current;
+  return JsonValue(current);
 }
 
 JsonArray::JsonArray() { m_value = JsonArray::create(); }
@@ -582,6 +727,10 @@ JsonValue JsonArray::at(size_t position) const {
   return JsonValue(api()->array_get(m_value, position));
 }
 
+JsonRef JsonArray::view_at(size_t position) const {
+  return JsonRef(api()->array_get(m_value, position));
+}
+
 JsonArray::JsonArray(const var::StringList &list) {
   m_value = JsonArray::create();
   for (const auto &entry : list) {
@@ -655,40 +804,198 @@ JsonArray &JsonArray::clear() {
 
 var::StringViewList JsonArray::string_view_list() const {
   var::StringViewList result;
-  result.reserve(count());
-  for (u32 i = 0; i < count(); i++) {
-    result.push_back(var::StringView(at(i).to_cstring()));
-  }
+  copy_to(result);
   return result;
 }
 
 var::Vector<s32> JsonArray::integer_list() const {
   var::Vector<s32> result;
-  result.reserve(count());
-  for (u32 i = 0; i < count(); i++) {
-    result.push_back(at(i).to_integer());
-  }
+  copy_to(result);
   return result;
 }
 
 var::Vector<float> JsonArray::float_list() const {
   var::Vector<float> result;
-  result.reserve(count());
-  for (u32 i = 0; i < count(); i++) {
-    result.push_back(at(i).to_real());
-  }
+  copy_to(result);
   return result;
 }
 
 var::Vector<bool> JsonArray::bool_list() const {
   var::Vector<bool> result;
-  result.reserve(count());
-  for (u32 i = 0; i < count(); i++) {
-    result.push_back(at(i).to_bool());
-  }
+  copy_to(result);
   return result;
 }
 
+namespace {
+
+// false if is_strict and value has another type
+bool convert_value(const json_t *value, bool is_strict, s32 &result) {
+  if (is_strict) {
+    if (!json_is_integer(value)) {
+      return false;
+    }
+    // json_int_t is 64 bits
+    const json_int_t input = JsonValue::api()->integer_value(value);
+    if (
+      input < std::numeric_limits<s32>::min()
+      || input > std::numeric_limits<s32>::max()) {
+      return false;
+    }
+    result = static_cast<s32>(input);
+    return true;
+  }
+  result = integer_value(value);
+  return true;
+}
+
+bool convert_value(const json_t *value, bool is_strict, float &result) {
+  if (is_strict && !json_is_number(value)) {
+    return false;
+  }
+  result = real_value(value);
+  return true;
+}
+
+bool convert_value(const json_t *value, bool is_strict, bool &result) {
+  if (is_strict && !json_is_boolean(value)) {
+    return false;
+  }
+  result = bool_value(value);
+  return true;
+}
+
+bool convert_value(
+  const json_t *value,
+  bool is_strict,
+  var::StringView &result) {
+  if (is_strict && !json_is_string(value)) {
+    return false;
+  }
+  result = var::StringView(cstring_value(value));
+  return true;
+}
+
+template <typename T> struct PointerOutput {
+  T *list;
+  bool operator()(size_t i, const json_t *value, bool is_strict) const {
+    return convert_value(value, is_strict, list[i]);
+  }
+};
+
+// appends because var::Vector<bool> has no bool references
+template <typename T> struct VectorOutput {
+  var::Vector<T> &list;
+  bool operator()(size_t i, const json_t *value, bool is_strict) const {
+    T item;
+    if (!convert_value(value, is_strict, item)) {
+      return false;
+    }
+    list.push_back(item);
+    return true;
+  }
+};
+
+} // namespace
+
+template <typename Output>
+size_t JsonArray::copy_values(
+  size_t size,
+  size_t offset,
+  IsStrict is_strict,
+  Output output) const {
+  API_RETURN_VALUE_IF_ERROR(0);
+  // count() and at() would go through the API for every element
+  const size_t array_size = api()->array_size(m_value);
+  if (offset >= array_size) {
+    return 0;
+  }
+
+  const size_t end = array_size - offset > size ? offset + size : array_size;
+  for (size_t i = offset; i < end; i++) {
+    // array_get() doesn't take a reference
+    const json_t *value = api()->array_get(m_value, i);
+    if (!output(i - offset, value, is_strict == IsStrict::yes)) {
+      API_RETURN_VALUE_ASSIGN_ERROR(
+        i - offset,
+        "array element has the wrong type",
+        EINVAL);
+    }
+  }
+  return end - offset;
+}
+
+size_t JsonArray::copy_to(
+  s32 *list,
+  size_t size,
+  size_t offset,
+  IsStrict is_strict) const {
+  return copy_values(size, offset, is_strict, PointerOutput<s32>{list});
+}
+
+size_t JsonArray::copy_to(
+  float *list,
+  size_t size,
+  size_t offset,
+  IsStrict is_strict) const {
+  return copy_values(size, offset, is_strict, PointerOutput<float>{list});
+}
+
+size_t JsonArray::copy_to(
+  bool *list,
+  size_t size,
+  size_t offset,
+  IsStrict is_strict) const {
+  return copy_values(size, offset, is_strict, PointerOutput<bool>{list});
+}
+
+size_t JsonArray::copy_to(
+  var::StringView *list,
+  size_t size,
+  size_t offset,
+  IsStrict is_strict) const {
+  return copy_values(
+    size,
+    offset,
+    is_strict,
+    PointerOutput<var::StringView>{list});
+}
+
+const JsonArray &
+JsonArray::copy_to(var::Vector<s32> &list, IsStrict is_strict) const {
+  const size_t size = api()->array_size(m_value);
+  list.clear();
+  list.reserve(size);
+  copy_values(size, 0, is_strict, VectorOutput<s32>{list});
+  return *this;
+}
+
+const JsonArray &
+JsonArray::copy_to(var::Vector<float> &list, IsStrict is_strict) const {
+  const size_t size = api()->array_size(m_value);
+  list.clear();
+  list.reserve(size);
+  copy_values(size, 0, is_strict, VectorOutput<float>{list});
+  return *this;
+}
+
+const JsonArray &
+JsonArray::copy_to(var::Vector<bool> &list, IsStrict is_strict) const {
+  const size_t size = api()->array_size(m_value);
+  list.clear();
+  list.reserve(size);
+  copy_values(size, 0, is_strict, VectorOutput<bool>{list});
+  return *this;
+}
+
+const JsonArray &
+JsonArray::copy_to(var::StringViewList &list, IsStrict is_strict) const {
+  const size_t size = api()->array_size(m_value);
+  list.clear();
+  list.reserve(size);
+  copy_values(size, 0, is_strict, VectorOutput<var::StringView>{list});
+  return *this;
+}
+
 JsonString::JsonString() { m_value = JsonString::create(); }
 
 JsonString::JsonString(const char *str) {
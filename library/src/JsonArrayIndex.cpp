@@ -0,0 +1,202 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#include <cstdio>
+#include <cstring>
+
+#include <fs/DataFile.hpp>
+#include <var/Data.hpp>
+#include <var/StringView.hpp>
+
+#include "json/JsonArrayIndex.hpp"
+
+#include "JsonScanner.hpp"
+
+using namespace var;
+using namespace json;
+
+namespace {
+
+#if defined __link
+constexpr size_t build_buffer_size = 64 * 1024;
+#else
+constexpr size_t build_buffer_size = 256;
+#endif
+
+constexpr const char *header = "JsonArrayIndex 1 ";
+
+} // namespace
+
+JsonArrayIndex &JsonArrayIndex::build(const fs::FileObject &file) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+
+  m_offset_list = var::Vector<size_t>();
+  m_source_size = file.size();
+
+  size_t depth = 0;
+  // an array with one scalar has no events between the brackets
+  bool is_value = false;
+  bool is_closed = false;
+
+  var::Data buffer(build_buffer_size);
+  JsonStructuralScanner scanner;
+
+  do {
+    const size_t location = file.location();
+    const int read_result = file.read(buffer).return_value();
+    if (read_result <= 0) {
+      break;
+    }
+
+    const char *data = static_cast<const char *>(buffer.data());
+    const size_t length = read_result;
+    bool is_not_array = false;
+
+    const size_t stop = scanner.scan(data, length, [&](size_t offset, char c) {
+      switch (c) {
+      case '{':
+      case '[':
+        if (depth == 0) {
+          if (c == '{') {
+            is_not_array = true;
+            return false;
+          }
+          m_offset_list.push_back(location + offset);
+        } else {
+          is_value = true;
+        }
+        depth++;
+        return true;
+
+      case '}':
+      case ']':
+        depth--;
+        if (depth == 0) {
+          m_offset_list.push_back(location + offset);
+          is_closed = true;
+          return false;
+        }
+        return true;
+
+      case ',':
+        if (depth == 1) {
+          m_offset_list.push_back(location + offset);
+        }
+        return true;
+
+      default:
+        is_value = is_value || depth > 0;
+        return true;
+      }
+    });
+
+    if (is_not_array) {
+      m_offset_list = var::Vector<size_t>();
+      API_RETURN_VALUE_ASSIGN_ERROR(*this, "not an array", EINVAL);
+    }
+
+    if (stop != JsonStructuralScanner::npos) {
+      break;
+    }
+  } while (true);
+
+  if (is_closed == false) {
+    m_offset_list = var::Vector<size_t>();
+    API_RETURN_VALUE_ASSIGN_ERROR(*this, "array is incomplete", EINVAL);
+  }
+
+  if (m_offset_list.count() == 2 && is_value == false) {
+    // [] or [ 1 ]
+    const size_t size = m_offset_list.at(1) - m_offset_list.at(0) - 1;
+    bool is_empty = true;
+    if (size) {
+      var::Data element(size);
+      file.seek(m_offset_list.at(0) + 1).read(element);
+      const char *data = static_cast<const char *>(element.data());
+      for (size_t i = 0; i < size; i++) {
+        is_empty = is_empty && JsonScanner::is_whitespace(data[i]);
+      }
+    }
+    if (is_empty) {
+      m_offset_list.pop_back();
+    }
+  }
+
+  return *this;
+}
+
+const JsonArrayIndex &JsonArrayIndex::save(const fs::FileObject &file) const {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  char line[64];
+  snprintf(
+    line,
+    sizeof(line),
+    "%s%llu %llu\n",
+    header,
+    static_cast<unsigned long long>(m_source_size),
+    static_cast<unsigned long long>(m_offset_list.count()));
+
+  var::String output(line);
+  for (const auto offset : m_offset_list) {
+    snprintf(
+      line,
+      sizeof(line),
+      "%llu\n",
+      static_cast<unsigned long long>(offset));
+    output.append(line);
+    if (output.length() >= build_buffer_size) {
+      file.write(output);
+      output.clear();
+    }
+  }
+  file.write(output);
+  return *this;
+}
+
+JsonArrayIndex &JsonArrayIndex::load(const fs::FileObject &file) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  fs::DataFile data_file
+    = fs::DataFile().reserve(file.size()).write(file).move();
+  API_RETURN_VALUE_IF_ERROR(*this);
+
+  m_offset_list = var::Vector<size_t>();
+  StringView input(
+    static_cast<const char *>(data_file.data().data()),
+    data_file.data().size());
+
+  const size_t header_length = strlen(header);
+  const size_t header_end = input.find("\n");
+  if (
+    header_end == StringView::npos || header_end < header_length
+    || StringView(input.data(), header_length) != header) {
+    API_RETURN_VALUE_ASSIGN_ERROR(*this, "invalid array index", EINVAL);
+  }
+
+  StringView fields(input.data() + header_length, header_end - header_length);
+  const size_t space = fields.find(" ");
+  if (space == StringView::npos) {
+    API_RETURN_VALUE_ASSIGN_ERROR(*this, "invalid array index", EINVAL);
+  }
+  m_source_size = StringView(fields.data(), space).to_unsigned_long();
+  const size_t offset_count
+    = StringView(fields.data() + space + 1, fields.length() - space - 1)
+        .to_unsigned_long();
+
+  m_offset_list.reserve(offset_count);
+  input = StringView(
+    input.data() + header_end + 1,
+    input.length() - header_end - 1);
+  while (input.length()) {
+    const size_t end = input.find("\n");
+    if (end == StringView::npos) {
+      break;
+    }
+    m_offset_list.push_back(StringView(input.data(), end).to_unsigned_long());
+    input = StringView(input.data() + end + 1, input.length() - end - 1);
+  }
+
+  if (m_offset_list.count() != offset_count) {
+    m_offset_list = var::Vector<size_t>();
+    API_RETURN_VALUE_ASSIGN_ERROR(*this, "invalid array index", EINVAL);
+  }
+  return *this;
+}
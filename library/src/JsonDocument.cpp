@@ -1,14 +1,40 @@
 // Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
 
+#include <cstring>
+
 #if defined __link
 #include "xml2json.hpp"
 #endif
 
+#if defined __link
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+#if defined __link && !defined __win32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define JSON_DOCUMENT_USE_MMAP 1
+#endif
+
 #include <fs/DataFile.hpp>
 #include <printer/Printer.hpp>
+#include <var/Data.hpp>
 #include <var/Deque.hpp>
 
 #include "json/JsonDocument.hpp"
+#include "json/JsonReader.hpp"
+#include "json/JsonSeekIndex.hpp"
+
+#include "JsonScanner.hpp"
 
 using namespace var;
 using namespace json;
@@ -17,6 +43,15 @@ using namespace printer;
 
 
 namespace {
+#if defined __link
+constexpr size_t seek_buffer_size = 64 * 1024;
+// pages read by for_each_line(), longer lines are joined across pages
+constexpr size_t line_buffer_size = 64 * 1024;
+#else
+constexpr size_t seek_buffer_size = 256;
+constexpr size_t line_buffer_size = 256;
+#endif
+
 int write_file_data(const char *buffer, size_t buflen, void *data) {
   reinterpret_cast<const fs::File *>(data)->write(View(buffer, buflen));
   if (api::ExecutionContext::return_value() != buflen) {
@@ -25,12 +60,633 @@ int write_file_data(const char *buffer, size_t buflen, void *data) {
   return 0;
 }
 
+// combines the small fragments from the jansson dumper into larger writes
+class FileWriteBuffer {
+public:
+  FileWriteBuffer(const fs::FileObject &file, size_t size)
+    : m_file(file), m_buffer(size) {}
+
+  int write(const char *buffer, size_t buflen) {
+    if (m_offset + buflen > m_buffer.size() && flush() < 0) {
+      return -1;
+    }
+
+    if (buflen >= m_buffer.size()) {
+      return write_file_data(buffer, buflen, (void *)&m_file);
+    }
+
+    memcpy(static_cast<char *>(m_buffer.data()) + m_offset, buffer, buflen);
+    m_offset += buflen;
+    return 0;
+  }
+
+  int flush() {
+    const size_t size = m_offset;
+    m_offset = 0;
+    if (size == 0) {
+      return 0;
+    }
+    return write_file_data(
+      static_cast<const char *>(m_buffer.data()),
+      size,
+      (void *)&m_file);
+  }
+
+private:
+  const fs::FileObject &m_file;
+  var::Data m_buffer;
+  size_t m_offset = 0;
+};
+
+int write_buffered_file_data(const char *buffer, size_t buflen, void *data) {
+  return reinterpret_cast<FileWriteBuffer *>(data)->write(buffer, buflen);
+}
+
+// parses one JSON Lines record, returns false for a blank line
+bool load_line(
+  StringView line,
+  u32 flags,
+  json_t *&result,
+  json_error_t *error) {
+  if (line.length() && line.at(line.length() - 1) == '\r') {
+    line.pop_back();
+  }
+
+  bool is_blank = true;
+  for (size_t i = 0; i < line.length(); i++) {
+    if (line.at(i) != ' ' && line.at(i) != '\t') {
+      is_blank = false;
+      break;
+    }
+  }
+  if (is_blank) {
+    return false;
+  }
+
+  result
+    = JsonValue::api()->loadb(line.data(), line.length(), flags, error);
+  return true;
+}
+
+int write_string_data(const char *buffer, size_t buflen, void *data) {
+  reinterpret_cast<var::String *>(data)->append(StringView(buffer, buflen));
+  return 0;
+}
+
 size_t read_file_data(void *buffer, size_t buflen, void *data) {
   return reinterpret_cast<const fs::File *>(data)
     ->read(View(buffer, buflen))
     .return_value();
 }
 
+// creates only the values on the projection paths, everything else is
+// skipped as the reader scans it
+class ProjectionHandler : public JsonReader::Handler {
+public:
+  ProjectionHandler(const var::StringViewList &projection, u32 flags)
+    : m_is_int_as_real(flags & JSON_DECODE_INT_AS_REAL) {
+    m_node_list.push_back(Node());
+    for (const auto &path : projection) {
+      size_t parent = 0;
+      for (const auto item : path.split("/")) {
+        if (item.is_empty() == false) {
+          parent = add_node(parent, item);
+        }
+      }
+      m_node_list.at(parent).is_terminal = true;
+    }
+  }
+
+  ~ProjectionHandler() {
+    if (m_root) {
+      JsonValue::api()->decref(m_root);
+    }
+  }
+
+  bool is_error() const { return m_is_error; }
+
+  json_t *take_root() {
+    json_t *result = m_root;
+    m_root = nullptr;
+    return result;
+  }
+
+  bool null() override {
+    if (resolve() == capture) {
+      return insert(JsonValue::api()->create_null()) && end_value();
+    }
+    return end_value();
+  }
+
+  bool boolean(bool value) override {
+    if (resolve() == capture) {
+      return insert(
+               value ? JsonValue::api()->create_true()
+                     : JsonValue::api()->create_false())
+             && end_value();
+    }
+    return end_value();
+  }
+
+  bool integer(s64 value) override {
+    if (resolve() == capture) {
+      return insert(
+               m_is_int_as_real ? JsonValue::api()->create_real(value)
+                                : JsonValue::api()->create_integer(value))
+             && end_value();
+    }
+    return end_value();
+  }
+
+  bool real(double value) override {
+    if (resolve() == capture) {
+      return insert(JsonValue::api()->create_real(value)) && end_value();
+    }
+    return end_value();
+  }
+
+  bool string(const var::StringView value) override {
+    if (resolve() == capture) {
+      // the reader has already validated the encoding
+      return insert(JsonValue::api()->create_stringn_nocheck(
+               value.data(),
+               value.length()))
+             && end_value();
+    }
+    return end_value();
+  }
+
+  bool start_object() override { return start_container(true); }
+
+  bool key(const var::StringView key) override {
+    if (m_skip_depth == 0) {
+      m_frame_list.back().key = String(key);
+    }
+    return true;
+  }
+
+  bool end_object(size_t) override { return end_container(); }
+  bool start_array() override { return start_container(false); }
+  bool end_array(size_t) override { return end_container(); }
+
+private:
+  static constexpr size_t skip = static_cast<size_t>(-1);
+  static constexpr size_t capture = static_cast<size_t>(-2);
+
+  struct Node {
+    size_t parent = skip;
+    var::StringView item;
+    // value of [n] or {n}
+    size_t offset = skip;
+    bool is_terminal = false;
+  };
+
+  struct Frame {
+    // node in m_node_list or capture
+    size_t node;
+    json_t *container;
+    bool is_object;
+    size_t index;
+    var::String key;
+  };
+
+  var::Vector<Node> m_node_list;
+  var::Vector<Frame> m_frame_list;
+  json_t *m_root = nullptr;
+  size_t m_skip_depth = 0;
+  bool m_is_int_as_real;
+  bool m_is_error = false;
+
+  size_t add_node(size_t parent, const var::StringView item) {
+    for (size_t i = 1; i < m_node_list.count(); i++) {
+      const auto &node = m_node_list.at(i);
+      if (node.parent == parent && node.item == item) {
+        return i;
+      }
+    }
+
+    Node node;
+    node.parent = parent;
+    node.item = item;
+    const char last = item.at(item.length() - 1);
+    if (
+      item.length() > 2
+      && ((item.at(0) == '[' && last == ']')
+          || (item.at(0) == '{' && last == '}'))) {
+      node.offset
+        = StringView(item.data() + 1, item.length() - 2).to_unsigned_long();
+    }
+    m_node_list.push_back(node);
+    return m_node_list.count() - 1;
+  }
+
+  // what to do with the value that is starting
+  size_t resolve() const {
+    if (m_skip_depth) {
+      return skip;
+    }
+
+    if (m_frame_list.count() == 0) {
+      return m_node_list.at(0).is_terminal ? capture : 0;
+    }
+
+    const auto &frame = m_frame_list.back();
+    if (frame.node == capture) {
+      return capture;
+    }
+
+    for (size_t i = 1; i < m_node_list.count(); i++) {
+      const auto &node = m_node_list.at(i);
+      if (node.parent != frame.node) {
+        continue;
+      }
+
+      const char bracket = node.item.at(0);
+      const bool is_match
+        = frame.is_object
+            ? (node.item == frame.key.string_view()
+               || (bracket == '{' && node.offset == frame.index))
+            : (bracket == '[' && node.offset == frame.index);
+      if (is_match) {
+        return node.is_terminal ? capture : i;
+      }
+    }
+    return skip;
+  }
+
+  bool insert(json_t *value) {
+    if (value == nullptr) {
+      m_is_error = true;
+      return false;
+    }
+
+    if (m_frame_list.count() == 0) {
+      m_root = value;
+      return true;
+    }
+
+    auto &frame = m_frame_list.back();
+    int result = 0;
+    if (frame.is_object) {
+      result = JsonValue::api()->object_setn(
+        frame.container,
+        frame.key.cstring(),
+        frame.key.length(),
+        value);
+    } else {
+      // skipped elements are kept as null so positions match the source
+      while (result == 0
+             && JsonValue::api()->array_size(frame.container) < frame.index) {
+        json_t *null_value = JsonValue::api()->create_null();
+        result = JsonValue::api()->array_append(frame.container, null_value);
+        JsonValue::api()->decref(null_value);
+      }
+      if (result == 0) {
+        result = JsonValue::api()->array_append(frame.container, value);
+      }
+    }
+
+    JsonValue::api()->decref(value);
+    if (result < 0) {
+      m_is_error = true;
+      return false;
+    }
+    return true;
+  }
+
+  bool end_value() {
+    if (m_skip_depth == 0 && m_frame_list.count()) {
+      m_frame_list.back().index++;
+    }
+    return true;
+  }
+
+  bool start_container(bool is_object) {
+    const size_t target = resolve();
+    if (target == skip) {
+      m_skip_depth++;
+      return true;
+    }
+
+    json_t *container = is_object ? JsonValue::api()->create_object()
+                                  : JsonValue::api()->create_array();
+    // the parent (or m_root) owns the container once it is inserted
+    if (!insert(container)) {
+      return false;
+    }
+    m_frame_list.push_back({target, container, is_object, 0, String()});
+    return true;
+  }
+
+  bool end_container() {
+    if (m_skip_depth) {
+      m_skip_depth--;
+    } else {
+      m_frame_list.pop_back();
+    }
+    return end_value();
+  }
+};
+
+template <class Input>
+json_t *load_projection(
+  const Input &input,
+  const var::StringViewList &projection,
+  u32 flags,
+  JsonError &error) {
+  ProjectionHandler handler(projection, flags);
+  JsonReader reader;
+  reader
+    .set_flags(
+      flags & JSON_DISABLE_EOF_CHECK ? JsonReader::Flags::disable_eof_check
+                                     : JsonReader::Flags::null)
+    .parse(input, handler);
+  error = reader.error();
+  if (reader.is_error()) {
+    return nullptr;
+  }
+
+  if (handler.is_error()) {
+    API_RETURN_VALUE_ASSIGN_ERROR(nullptr, "failed to create value", ENOMEM);
+  }
+  return handler.take_root();
+}
+
+// yes stops at the end of the first value (e.g. an indexed container)
+enum class IsSingleValue { no, yes };
+// no stops as soon as the start of each container is found
+enum class IsEndNeeded { no, yes };
+
+// finds the objects and arrays at path_list in one pass and stops once all
+// of them are found; the start of an entry is npos if it isn't found
+var::Vector<JsonSeekIndex::Entry> find_containers(
+  const var::StringViewList &path_list,
+  const fs::FileObject &file,
+  IsSingleValue is_single_value_option,
+  IsEndNeeded is_end_needed_option) {
+  constexpr size_t npos = JsonStructuralScanner::npos;
+  const bool is_single_value = is_single_value_option == IsSingleValue::yes;
+  const bool is_end_needed = is_end_needed_option == IsEndNeeded::yes;
+
+  // the paths are merged into a tree so each container is checked once
+  struct Node {
+    size_t parent;
+    StringView key;
+    // value of [n], npos for keys
+    size_t index;
+    bool is_parent;
+    bool is_found;
+    // paths that end at this node
+    var::Vector<size_t> path_index_list;
+  };
+
+  struct Container {
+    bool is_object;
+    size_t index;
+    // node in node_list or npos if it isn't on a path
+    size_t node;
+    bool is_target;
+  };
+
+  var::Vector<JsonSeekIndex::Entry> result;
+  var::Vector<Node> node_list;
+  node_list.push_back({npos, StringView(), npos, false, false, {}});
+
+  for (size_t i = 0; i < path_list.count(); i++) {
+    const auto path = path_list.at(i);
+    result.push_back(
+      JsonSeekIndex::Entry().set_path(var::String(path)).set_start(npos));
+
+    size_t node = 0;
+    for (const auto item : path.split("/")) {
+      if (item.is_empty()) {
+        continue;
+      }
+
+      const bool is_index = item.length() > 2 && item.at(0) == '['
+                            && item.at(item.length() - 1) == ']';
+      const size_t index
+        = is_index
+            ? StringView(item.data() + 1, item.length() - 2).to_unsigned_long()
+            : npos;
+
+      size_t child = npos;
+      for (size_t j = 1; j < node_list.count() && child == npos; j++) {
+        const auto &next = node_list.at(j);
+        if (next.parent == node && next.key == item) {
+          child = j;
+        }
+      }
+
+      if (child == npos) {
+        node_list.push_back({node, item, index, false, false, {}});
+        child = node_list.count() - 1;
+      }
+      node_list.at(node).is_parent = true;
+      node = child;
+    }
+    node_list.at(node).path_index_list.push_back(i);
+  }
+
+  size_t remaining = path_list.count();
+  if (remaining == 0) {
+    return result;
+  }
+
+  var::Vector<Container> container_list;
+  bool is_string = false;
+  bool is_key = false;
+  bool is_expecting_key = false;
+  bool is_end = false;
+
+  // keys are only kept when they can lead to a path (they may span reads)
+  var::String key;
+  bool is_recording = false;
+  size_t key_start = 0;
+
+  var::Data buffer(seek_buffer_size);
+  JsonStructuralScanner scanner;
+
+  do {
+    const size_t location = file.location();
+    const int read_result = file.read(buffer).return_value();
+    if (read_result <= 0) {
+      break;
+    }
+
+    const char *data = static_cast<const char *>(buffer.data());
+    const size_t length = read_result;
+    key_start = 0;
+
+    scanner.scan(data, length, [&](size_t offset, char c) {
+      switch (c) {
+      case '"':
+        is_string = !is_string;
+        if (is_string) {
+          is_key = is_expecting_key;
+          is_recording = is_key && container_list.back().node != npos
+                         && node_list.at(container_list.back().node).is_parent;
+          if (is_recording) {
+            key.clear();
+            key_start = offset + 1;
+          }
+        } else if (is_key) {
+          is_key = false;
+          is_expecting_key = false;
+          if (is_recording) {
+            key.append(StringView(data + key_start, offset - key_start));
+            is_recording = false;
+          }
+        }
+        return true;
+
+      case ',':
+        if (container_list.count()) {
+          if (container_list.back().is_object) {
+            is_expecting_key = true;
+          } else {
+            container_list.back().index++;
+          }
+        }
+        return true;
+
+      case '{':
+      case '[': {
+        size_t node = npos;
+        if (container_list.count() == 0) {
+          node = 0;
+        } else {
+          const auto &parent = container_list.back();
+          if (parent.node != npos && node_list.at(parent.node).is_parent) {
+            for (size_t i = 1; i < node_list.count() && node == npos; i++) {
+              const auto &next = node_list.at(i);
+              if (
+                next.parent == parent.node
+                && (parent.is_object
+                      ? next.index == npos && next.key == key.string_view()
+                      : next.index == parent.index)) {
+                node = i;
+              }
+            }
+          }
+        }
+
+        bool is_target = false;
+        if (node != npos) {
+          auto &target = node_list.at(node);
+          is_target = target.path_index_list.count() && !target.is_found;
+          if (is_target) {
+            target.is_found = true;
+            for (const auto path_index : target.path_index_list) {
+              result.at(path_index).set_start(location + offset);
+            }
+            if (!is_end_needed) {
+              remaining -= target.path_index_list.count();
+            }
+          }
+        }
+
+        container_list.push_back({c == '{', 0, node, is_target});
+        is_expecting_key = c == '{';
+        return remaining > 0;
+      }
+
+      case '}':
+      case ']':
+        if (container_list.count()) {
+          const auto &container = container_list.back();
+          if (container.is_target && is_end_needed) {
+            const auto &target = node_list.at(container.node);
+            for (const auto path_index : target.path_index_list) {
+              result.at(path_index).set_end(location + offset + 1);
+            }
+            remaining -= target.path_index_list.count();
+          }
+          container_list.pop_back();
+          if (remaining == 0) {
+            return false;
+          }
+          if (is_single_value && container_list.count() == 0) {
+            is_end = true;
+            return false;
+          }
+        }
+        is_expecting_key = false;
+        return true;
+
+      default:
+        // ':'
+        return true;
+      }
+    });
+
+    if (is_end || remaining == 0) {
+      break;
+    }
+
+    if (is_recording) {
+      // the key continues in the next read
+      key.append(StringView(data + key_start, length - key_start));
+    }
+  } while (true);
+
+  return result;
+}
+
+// uses the deepest container on path that is in index and scans the rest of
+// the path inside that container
+JsonSeekIndex::Entry find_indexed_container(
+  const var::StringView path,
+  const fs::FileObject &file,
+  const JsonSeekIndex &index,
+  IsEndNeeded is_end_needed) {
+  if (index.source_size() != file.size()) {
+    // the offsets would point into different bytes
+    API_RETURN_VALUE_ASSIGN_ERROR(
+      JsonSeekIndex::Entry()
+        .set_path(String(path))
+        .set_start(JsonStructuralScanner::npos),
+      "seek index doesn't match the file size",
+      ESTALE);
+  }
+
+  StringViewList item_list;
+  for (const auto item : path.split("/")) {
+    if (item.is_empty() == false) {
+      item_list.push_back(item);
+    }
+  }
+
+  const size_t depth = item_list.count() < index.maximum_depth()
+                         ? item_list.count()
+                         : index.maximum_depth();
+  String indexed_path;
+  String remaining_path;
+  for (size_t i = 0; i < item_list.count(); i++) {
+    (i < depth ? indexed_path : remaining_path)
+      .append("/")
+      .append(item_list.at(i));
+  }
+
+  const auto entry = index.find(indexed_path);
+  if (entry.is_valid() == false) {
+    return JsonSeekIndex::Entry()
+      .set_path(String(path))
+      .set_start(JsonStructuralScanner::npos);
+  }
+
+  if (remaining_path.is_empty()) {
+    return entry;
+  }
+
+  file.seek(entry.start());
+  StringViewList path_list;
+  path_list.push_back(remaining_path);
+  return find_containers(path_list, file, IsSingleValue::yes, is_end_needed)
+    .at(0)
+    .set_path(String(path));
+}
+
 } // namespace
 
 #if defined __link
@@ -62,25 +718,38 @@ JsonValue JsonDocument::from_string(const StringView json) {
   return value;
 }
 
-var::String JsonDocument::to_string(const JsonValue &value) const {
-  API_RETURN_VALUE_IF_ERROR(String());
+JsonValue JsonDocument::from_string(
+  const var::StringView json,
+  const var::StringViewList &projection) {
+  API_RETURN_VALUE_IF_ERROR(JsonValue());
+  JsonValue value;
+  value.m_value = load_projection(json, projection, json_flags(), m_error);
+  return value;
+}
 
-  u32 size = API_SYSTEM_CALL(
-    "",
-    JsonValue::api()->dumpb(value.m_value, 0, 0, json_flags()));
-  if (size == 0) {
-    return var::String();
-  }
+var::String JsonDocument::to_string(const JsonValue &value) const {
   var::String result;
-  result.resize(size);
+  to_string(value, result);
+  return result;
+}
 
+const JsonDocument &
+JsonDocument::to_string(const JsonValue &value, var::String &output) const {
+  output.clear();
+  API_RETURN_VALUE_IF_ERROR(*this);
+  // one pass over the tree, output grows as needed
   if (
-    JsonValue::api()
-      ->dumpb(value.m_value, result.to_char(), result.capacity(), json_flags())
-    == 0) {
-    return var::String();
+    API_SYSTEM_CALL(
+      "",
+      JsonValue::api()->dump_callback(
+        value.m_value,
+        write_string_data,
+        &output,
+        json_flags()))
+    < 0) {
+    output.clear();
   }
-  return result;
+  return *this;
 }
 
 JsonValue JsonDocument::load(const fs::FileObject &file) {
@@ -96,16 +765,369 @@ JsonValue JsonDocument::load(const fs::FileObject &file) {
   return value;
 }
 
+JsonValue JsonDocument::load(
+  const fs::FileObject &file,
+  const var::StringViewList &projection) {
+  API_RETURN_VALUE_IF_ERROR(JsonValue());
+  JsonValue value;
+  value.m_value = load_projection(file, projection, json_flags(), m_error);
+  return value;
+}
+
+JsonValue JsonDocument::load_mapped(const var::StringView path) {
+  API_RETURN_VALUE_IF_ERROR(JsonValue());
+#if defined JSON_DOCUMENT_USE_MMAP
+  const int fd
+    = API_SYSTEM_CALL("", ::open(PathString(path).cstring(), O_RDONLY));
+  if (fd < 0) {
+    return JsonValue();
+  }
+
+  struct stat file_stat;
+  if (API_SYSTEM_CALL("", ::fstat(fd, &file_stat)) < 0) {
+    ::close(fd);
+    return JsonValue();
+  }
+
+  const size_t size = file_stat.st_size;
+  void *region
+    = size ? ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  // the mapping remains valid after the descriptor is closed
+  ::close(fd);
+
+  if (region == MAP_FAILED) {
+    // empty files, pipes and special files can't be mapped
+    return load(fs::File(path, fs::OpenMode::read_only()));
+  }
+
+  ::madvise(region, size, MADV_SEQUENTIAL);
+  JsonValue result
+    = from_string(StringView(reinterpret_cast<const char *>(region), size));
+  ::munmap(region, size);
+  return result;
+#else
+  return load(fs::File(path, fs::OpenMode::read_only()));
+#endif
+}
+
+JsonDocument &JsonDocument::for_each_line(
+  const fs::FileObject &file,
+  LineCallback callback,
+  void *context) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+
+  // both buffers are reused for every record
+  var::Data page(line_buffer_size);
+  var::String partial_line;
+  size_t line_number = 0;
+  size_t location = 0;
+  bool is_continue = true;
+
+  const auto parse_line = [&](StringView line) {
+    line_number++;
+    const size_t line_location = location;
+    location += line.length() + 1;
+
+    JsonValue value;
+    if (!load_line(line, json_flags(), value.m_value, &m_error.m_value)) {
+      return;
+    }
+
+    if (value.m_value == nullptr) {
+      m_error.m_value.line = line_number;
+      m_error.m_value.position += line_location;
+    }
+    is_continue = callback(value, m_error, context);
+  };
+
+  int read_result;
+  do {
+    read_result = file.read(page).return_value();
+    if (read_result < 0) {
+      return *this;
+    }
+
+    const char *data = static_cast<const char *>(page.data());
+    size_t start = 0;
+    const char *end;
+    while (
+      is_continue
+      && (end = static_cast<const char *>(
+            memchr(data + start, '\n', read_result - start)))) {
+      const size_t length = end - (data + start);
+      if (partial_line.is_empty()) {
+        // parse in place when the whole line is in the page
+        parse_line(StringView(data + start, length));
+      } else {
+        partial_line.append(StringView(data + start, length));
+        parse_line(partial_line.string_view());
+        partial_line.clear();
+      }
+      start += length + 1;
+    }
+
+    if (is_continue) {
+      partial_line.append(StringView(data + start, read_result - start));
+    }
+  } while (read_result > 0 && is_continue);
+
+  if (is_continue && !partial_line.is_empty()) {
+    parse_line(partial_line.string_view());
+  }
+
+  return *this;
+}
+
+#if defined __link
+JsonDocument &JsonDocument::for_each_line(
+  const fs::FileObject &file,
+  const ParallelOptions &options,
+  LineCallback callback,
+  void *context) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+
+  // a run of complete lines, parsed by one worker
+  struct Chunk {
+    size_t sequence;
+    size_t line_number;
+    size_t location;
+    var::Data data;
+    size_t size;
+    var::Vector<JsonValue> value_list;
+    var::Vector<JsonError> error_list;
+  };
+
+  const size_t thread_count
+    = options.thread_count()
+        ? options.thread_count()
+        : std::max<size_t>(1, std::thread::hardware_concurrency());
+  // limits memory use when the consumer is slower than the workers
+  const size_t chunk_limit = thread_count * 2;
+  const size_t chunk_size = options.chunk_size() ? options.chunk_size() : 1;
+  const u32 flags = json_flags();
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<std::unique_ptr<Chunk>> input_queue;
+  std::map<size_t, std::unique_ptr<Chunk>> output_map;
+  bool is_input_done = false;
+  bool is_abort = false;
+
+  const auto parse_chunk = [flags](Chunk &chunk) {
+    const char *data = static_cast<const char *>(chunk.data.data());
+    size_t start = 0;
+    size_t line_number = chunk.line_number;
+    while (start < chunk.size) {
+      const size_t remaining = chunk.size - start;
+      const char *end
+        = static_cast<const char *>(memchr(data + start, '\n', remaining));
+      const size_t length = end ? size_t(end - (data + start)) : remaining;
+      line_number++;
+
+      JsonValue value;
+      JsonError error;
+      if (load_line(
+            StringView(data + start, length),
+            flags,
+            value.m_value,
+            &error.m_value)) {
+        if (value.m_value == nullptr) {
+          error.m_value.line = line_number;
+          error.m_value.position += chunk.location + start;
+          chunk.error_list.push_back(error);
+        }
+        chunk.value_list.push_back(std::move(value));
+      }
+      start += length + 1;
+    }
+  };
+
+  const auto worker = [&]() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      condition.wait(lock, [&] {
+        return is_abort || is_input_done || !input_queue.empty();
+      });
+      if (is_abort || input_queue.empty()) {
+        return;
+      }
+      auto chunk = std::move(input_queue.front());
+      input_queue.pop_front();
+      lock.unlock();
+      parse_chunk(*chunk);
+      lock.lock();
+      const size_t sequence = chunk->sequence;
+      output_map.emplace(sequence, std::move(chunk));
+      condition.notify_all();
+    }
+  };
+
+  // jansson seeds its hash table lazily, do it before the workers start
+  JsonValue::api()->object_seed(0);
+
+  std::vector<std::thread> thread_list;
+  for (size_t i = 0; i < thread_count; i++) {
+    thread_list.emplace_back(worker);
+  }
+
+  size_t read_sequence = 0;
+  size_t deliver_sequence = 0;
+  size_t line_number = 0;
+  size_t location = 0;
+  size_t in_flight = 0;
+  bool is_eof = false;
+  bool is_continue = true;
+  bool is_read_error = false;
+  const JsonError no_error;
+  var::Data carry;
+
+  const auto set_carry = [&carry](const char *data, size_t size) {
+    carry.resize(size);
+    if (size) {
+      memcpy(carry.data(), data, size);
+    }
+  };
+
+  while (is_continue) {
+    if (!is_eof && in_flight < chunk_limit) {
+      auto chunk = std::unique_ptr<Chunk>(new Chunk());
+      chunk->data.resize(carry.size() + chunk_size);
+      char *data = static_cast<char *>(chunk->data.data());
+      if (carry.size()) {
+        memcpy(data, carry.data(), carry.size());
+      }
+
+      const int read_result
+        = file.read(View(data + carry.size(), chunk_size)).return_value();
+      if (read_result < 0) {
+        // stops the workers, the error is assigned once they have joined
+        is_read_error = true;
+        is_continue = false;
+        break;
+      }
+      size_t size = carry.size() + read_result;
+      if (read_result == 0) {
+        is_eof = true;
+      } else {
+        // keep the trailing partial line for the next chunk
+        size_t end = size;
+        while (end > carry.size() && data[end - 1] != '\n') {
+          end--;
+        }
+        if (end == carry.size()) {
+          // no newline in this read, the line is longer than the chunk
+          set_carry(data, size);
+          continue;
+        }
+        set_carry(data + end, size - end);
+        size = end;
+      }
+
+      if (size == 0) {
+        continue;
+      }
+
+      chunk->sequence = read_sequence++;
+      chunk->line_number = line_number;
+      chunk->location = location;
+      chunk->size = size;
+      location += size;
+      for (const char *cursor = data;
+           (cursor = static_cast<const char *>(
+              memchr(cursor, '\n', data + size - cursor)));
+           cursor++) {
+        line_number++;
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      input_queue.push_back(std::move(chunk));
+      in_flight++;
+      condition.notify_all();
+      continue;
+    }
+
+    if (in_flight == 0) {
+      break;
+    }
+
+    std::unique_ptr<Chunk> chunk;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      condition.wait(lock, [&] {
+        return options.is_ordered() == IsOrdered::yes
+                 ? output_map.count(deliver_sequence) != 0
+                 : !output_map.empty();
+      });
+      auto iterator = options.is_ordered() == IsOrdered::yes
+                        ? output_map.find(deliver_sequence)
+                        : output_map.begin();
+      chunk = std::move(iterator->second);
+      output_map.erase(iterator);
+    }
+    in_flight--;
+    deliver_sequence++;
+
+    // callbacks always run on the calling thread
+    size_t error_offset = 0;
+    for (const auto &value : chunk->value_list) {
+      if (value.is_valid()) {
+        is_continue = callback(value, no_error, context);
+      } else {
+        m_error = chunk->error_list.at(error_offset++);
+        is_continue = callback(value, m_error, context);
+      }
+      if (!is_continue) {
+        break;
+      }
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    is_input_done = true;
+    is_abort = !is_continue;
+    condition.notify_all();
+  }
+
+  for (auto &thread : thread_list) {
+    thread.join();
+  }
+
+  if (is_read_error) {
+    API_RETURN_VALUE_ASSIGN_ERROR(*this, "failed to read json lines", EIO);
+  }
+  return *this;
+}
+#endif
+
 JsonDocument &
 JsonDocument::save(const JsonValue &value, const fs::FileObject &file) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  if (m_write_buffer_size == 0) {
+    return save(value, write_file_data, (void *)&file);
+  }
+
+  FileWriteBuffer buffer(file, m_write_buffer_size);
+  const int result = JsonValue::api()->dump_callback(
+    value.m_value,
+    write_buffered_file_data,
+    &buffer,
+    json_flags());
+  // whatever was dumped is written out even if the dump failed
+  const int flush_result = buffer.flush();
+  API_SYSTEM_CALL("", result < 0 ? result : flush_result);
+  return *this;
+}
+
+JsonDocument &JsonDocument::save(
+  const JsonValue &value,
+  json_dump_callback_t callback,
+  void *context) {
   API_RETURN_VALUE_IF_ERROR(*this);
   API_SYSTEM_CALL(
     "",
-    JsonValue::api()->dump_callback(
-      value.m_value,
-      write_file_data,
-      (void *)&file,
-      json_flags()));
+    JsonValue::api()
+      ->dump_callback(value.m_value, callback, context, json_flags()));
   return *this;
 }
 
@@ -119,188 +1141,165 @@ const JsonDocument &JsonDocument::seek(
    *   "name": "config",
    *   "config": {
    *     "name": "JsonAPI"
-   *   }
+   *   },
+   *   "list": [ { "name": "first" } ]
    * }
    *
    * use seek /config to seek to { "name": "JsonAPI" }
-   * use seek /name to seek to "config"
+   * use seek /list/[0] to seek to { "name": "first" }
    *
-   * Use
+   * Only objects and arrays can be found. If the path isn't found, the file
+   * is left at the end.
    *
    */
 
-  enum states {
-    state_find_key, // waiting for " to close the key
-    state_read_key, // waiting for " to close the key
-    state_read_value,
-    state_read_string_value,
-    state_find_colon
-  };
-
-  class Container {
-    API_AC(Container, KeyString, key);
-    API_AF(Container, JsonValue::Type, type, JsonValue::Type::null);
-    API_AF(Container, size_t, location, 0);
-    API_AF(Container, size_t, array_index, 0);
-  };
-
   API_ASSERT(path.at(0) == '/');
+  StringViewList path_list;
+  path_list.push_back(path);
+  const auto entry
+    = find_containers(path_list, file, IsSingleValue::no, IsEndNeeded::no)
+        .at(0);
+  if (entry.start() != JsonStructuralScanner::npos) {
+    file.seek(entry.start());
+  }
+  return *this;
+}
 
-  Deque<Container> container_stack;
-  const StringViewList token_list = path.split("/");
-  using InputBuffer = Array<char, 256>;
-  KeyString current_key = "<root>";
-  InputBuffer input_buffer;
+const JsonDocument &JsonDocument::seek(
+  const var::StringView path,
+  const fs::FileObject &file,
+  const JsonSeekIndex &index) const {
+  API_ASSERT(path.at(0) == '/');
+  API_RETURN_VALUE_IF_ERROR(*this);
+  const auto entry
+    = find_indexed_container(path, file, index, IsEndNeeded::no);
+  API_RETURN_VALUE_IF_ERROR(*this);
+  if (entry.start() == JsonStructuralScanner::npos) {
+    file.seek(0, fs::FileObject::Whence::end);
+  } else {
+    file.seek(entry.start());
+  }
+  return *this;
+}
 
-  const auto check_token_match = [](
-                                   const Deque<Container> &container_stack,
-                                   const StringViewList &token_list) -> bool {
-    if (token_list.count() != container_stack.count()) {
-      return false;
-    }
-    // ignore first value "<root>" for container, blank for token_list
-    int i = 0;
-    bool result = true;
-    for (const auto &entry : container_stack) {
-      if (i && (entry.key() != token_list.at(i))) {
-        // return false;
-        result = false;
-      }
-      i++;
+var::Vector<JsonSeekIndex::Entry> JsonDocument::seek_many(
+  const var::StringViewList &path_list,
+  const fs::FileObject &file) const {
+  API_RETURN_VALUE_IF_ERROR(var::Vector<JsonSeekIndex::Entry>());
+  auto result
+    = find_containers(path_list, file, IsSingleValue::no, IsEndNeeded::yes);
+  for (auto &entry : result) {
+    // not found or the file ends before the container does
+    if (entry.is_valid() == false) {
+      entry.set_start(0).set_end(0);
     }
-    return result;
-  };
-
-  const auto check_pop
-    = [](enum states state, char c, Deque<Container> &container_stack) {
-        if (c == '}' || c == ']') {
-          if (container_stack.count()) {
-            container_stack.pop_back();
-            if (container_stack.count()) {
-              if (container_stack.back().type() == JsonValue::Type::object) {
-                state = state_find_key;
-              } else {
-                state = state_read_value;
-              }
-            }
-          }
-        }
-        return state;
-      };
-
-  size_t array_index = 0;
-  int read_result;
-  enum states state = state_read_value;
-  char last = 0;
-
-  do {
-    size_t location = file.location();
-    size_t offset = 0;
-
-    input_buffer.fill(0);
-    read_result = file.read(input_buffer).return_value();
-
-    for (auto c : input_buffer) {
-      switch (state) {
-      case state_read_value: {
-        const enum states current_state = state;
-        const size_t count = container_stack.count();
-        if (c == '{') {
-          if (
-            container_stack.count()
-            && container_stack.back().type() == JsonValue::Type::array) {
-            current_key.format("[%d]", array_index);
-          }
-
-          container_stack.push_back(Container()
-                                      .set_array_index(array_index)
-                                      .set_key(current_key)
-                                      .set_location(location + offset)
-                                      .set_type(JsonValue::Type::object));
-          current_key.clear();
-          array_index = 0;
-          state = state_find_key;
-        } else if (c == '[') {
-
-          container_stack.push_back(Container()
-                                      .set_key(current_key)
-                                      .set_location(location + offset)
-                                      .set_type(JsonValue::Type::array));
-          current_key.clear();
-          state = state_read_value;
-        }
-
-        if (count != container_stack.count()) {
-          if (check_token_match(container_stack, token_list)) {
-            file.seek(location + offset);
-            return *this;
-          }
-          break;
-        }
-
-        if (c == ',') {
-          current_key.clear();
-
-          if (container_stack.back().type() == JsonValue::Type::object) {
-            state = state_find_key;
-          } else {
-            state = state_read_value;
-            array_index++;
-          }
-          break;
-        }
-
-        if (c == '"') {
-          state = state_read_string_value;
-          break;
-        }
+  }
+  return result;
+}
 
-        if (
-          (current_state != (state = check_pop(state, c, container_stack)))
-          && container_stack.count()) {
-          array_index = container_stack.back().array_index();
-        }
+JsonValue
+JsonDocument::load_at(const var::StringView path, const fs::FileObject &file) {
+  API_RETURN_VALUE_IF_ERROR(JsonValue());
+  StringViewList path_list;
+  path_list.push_back(path);
+  return load_at(
+    find_containers(path_list, file, IsSingleValue::no, IsEndNeeded::yes)
+      .at(0),
+    file);
+}
 
-        break;
-      }
-      case state_read_key:
+JsonValue JsonDocument::load_at(
+  const var::StringView path,
+  const fs::FileObject &file,
+  const JsonSeekIndex &index) {
+  API_RETURN_VALUE_IF_ERROR(JsonValue());
+  return load_at(
+    find_indexed_container(path, file, index, IsEndNeeded::yes),
+    file);
+}
 
-        if (last != '\\' && c == '"') {
-          state = state_find_colon;
-        } else {
-          current_key.append(c);
-        }
+JsonValue JsonDocument::load_at(
+  const JsonSeekIndex::Entry &entry,
+  const fs::FileObject &file) {
+  API_RETURN_VALUE_IF_ERROR(JsonValue());
+  if (entry.is_valid() == false) {
+    API_RETURN_VALUE_ASSIGN_ERROR(JsonValue(), "path not found", ENOENT);
+  }
 
-        break;
-      case state_find_colon:
-        if (c == ':') {
-          state = state_read_value;
-        }
-        break;
+  var::Data buffer(entry.size());
+  file.seek(entry.start()).read(buffer);
+  if (size_t(return_value()) != entry.size()) {
+    API_RETURN_VALUE_ASSIGN_ERROR(JsonValue(), "failed to read json", EIO);
+  }
+  return from_string(
+    StringView(static_cast<const char *>(buffer.data()), buffer.size()));
+}
 
-      case state_find_key:
-        if (c == '"') {
-          state = state_read_key;
-          break;
-        }
-        state = check_pop(state, c, container_stack);
+JsonValue JsonDocument::load_element(
+  const fs::FileObject &file,
+  const JsonArrayIndex &index,
+  size_t i) {
+  API_RETURN_VALUE_IF_ERROR(JsonValue());
+  if (index.source_size() != file.size()) {
+    API_RETURN_VALUE_ASSIGN_ERROR(
+      JsonValue(),
+      "array index doesn't match the file size",
+      ESTALE);
+  }
+  if (i >= index.count()) {
+    API_RETURN_VALUE_ASSIGN_ERROR(JsonValue(), "index out of range", EINVAL);
+  }
 
-        break;
+  const size_t size = index.end(i + 1) - index.start(i);
+  var::Data buffer(size);
+  file.seek(index.start(i)).read(buffer);
+  if (size_t(return_value()) != size) {
+    API_RETURN_VALUE_ASSIGN_ERROR(JsonValue(), "failed to read json", EIO);
+  }
 
-      case state_read_string_value:
-        if (last != '\\' && c == '"') {
-          state = state_read_value;
-        }
-        break;
-      }
+  // elements can be scalars
+  JsonValue value;
+  value.m_value = API_SYSTEM_CALL_NULL(
+    "",
+    JsonValue::api()->loadb(
+      static_cast<const char *>(buffer.data()),
+      size,
+      json_flags() | JSON_DECODE_ANY,
+      &m_error.m_value));
+  return value;
+}
 
-      last = c;
-      offset++;
-    }
+JsonArray JsonDocument::load_elements(
+  const fs::FileObject &file,
+  const JsonArrayIndex &index,
+  size_t begin,
+  size_t end) {
+  API_RETURN_VALUE_IF_ERROR(JsonArray());
+  if (index.source_size() != file.size()) {
+    API_RETURN_VALUE_ASSIGN_ERROR(
+      JsonArray(),
+      "array index doesn't match the file size",
+      ESTALE);
+  }
+  if (begin > end || end > index.count()) {
+    API_RETURN_VALUE_ASSIGN_ERROR(JsonArray(), "index out of range", EINVAL);
+  }
 
-  } while (read_result > 0);
+  if (begin == end) {
+    return JsonArray();
+  }
 
-  return *this;
+  // the elements and the commas between them are wrapped in [ and ]
+  const size_t size = index.end(end) - index.start(begin);
+  var::Data buffer(size + 2);
+  char *data = static_cast<char *>(buffer.data());
+  data[0] = '[';
+  data[size + 1] = ']';
+  file.seek(index.start(begin)).read(var::View(data + 1, size));
+  if (size_t(return_value()) != size) {
+    API_RETURN_VALUE_ASSIGN_ERROR(JsonArray(), "failed to read json", EIO);
+  }
+  return from_string(StringView(data, buffer.size())).to_array();
 }
 
 bool JsonDocument::is_valid(
@@ -0,0 +1,148 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#include <cstring>
+
+#include "json/JsonIncrementalParser.hpp"
+
+#include "JsonScanner.hpp"
+
+using namespace var;
+using namespace json;
+
+JsonIncrementalParser &JsonIncrementalParser::feed(const var::View data) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  if (m_length + data.size() > m_buffer.size()) {
+    const size_t size = m_buffer.size() * 2;
+    m_buffer.resize(
+      size > m_length + data.size() ? size : m_length + data.size());
+  }
+  memcpy(
+    static_cast<char *>(m_buffer.data()) + m_length,
+    data.to_const_void(),
+    data.size());
+  m_length += data.size();
+
+  process();
+  compact();
+
+  if (m_maximum_size && pending_size() > m_maximum_size) {
+    reset();
+    API_RETURN_VALUE_ASSIGN_ERROR(*this, "json value is too large", ENOMEM);
+  }
+  return *this;
+}
+
+JsonIncrementalParser &JsonIncrementalParser::finish() {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  if (process() && m_value_start != npos) {
+    if (m_is_scalar) {
+      deliver(m_value_start, m_length);
+    } else {
+      reset();
+      API_RETURN_VALUE_ASSIGN_ERROR(*this, "json value is incomplete", EINVAL);
+    }
+  }
+  return reset();
+}
+
+JsonIncrementalParser &JsonIncrementalParser::reset() {
+  m_length = 0;
+  m_consumed = 0;
+  m_scan_offset = 0;
+  m_value_start = npos;
+  m_depth = 0;
+  m_is_scalar = false;
+  m_is_string = false;
+  m_is_escape = false;
+  return *this;
+}
+
+bool JsonIncrementalParser::process() {
+  const char *data = static_cast<const char *>(m_buffer.data());
+  size_t position = m_scan_offset;
+  while (position < m_length) {
+    const char c = data[position];
+
+    if (m_value_start == npos) {
+      if (JsonScanner::is_whitespace(c)) {
+        m_consumed = ++position;
+        continue;
+      }
+      m_value_start = position++;
+      m_depth = (c == '{' || c == '[') ? 1 : 0;
+      m_is_string = c == '"';
+      m_is_scalar = m_depth == 0 && !m_is_string;
+      continue;
+    }
+
+    if (m_is_scalar) {
+      // numbers and literals end at the next delimiter, which is scanned
+      // again as the start of the next value
+      if (JsonScanner::is_delimiter(c)) {
+        m_scan_offset = position;
+        if (!deliver(m_value_start, position)) {
+          return false;
+        }
+        continue;
+      }
+      position++;
+      continue;
+    }
+
+    position++;
+    if (m_is_string) {
+      if (m_is_escape) {
+        m_is_escape = false;
+      } else if (c == '\\') {
+        m_is_escape = true;
+      } else if (c == '"') {
+        m_is_string = false;
+      }
+    } else if (c == '"') {
+      m_is_string = true;
+    } else if (c == '{' || c == '[') {
+      m_depth++;
+    } else if (c == '}' || c == ']') {
+      m_depth--;
+    }
+
+    if (m_depth == 0 && !m_is_string) {
+      m_scan_offset = position;
+      if (!deliver(m_value_start, position)) {
+        return false;
+      }
+    }
+  }
+  m_scan_offset = position;
+  return true;
+}
+
+bool JsonIncrementalParser::deliver(size_t start, size_t end) {
+  m_value_start = npos;
+  m_is_scalar = false;
+  m_consumed = end;
+
+  JsonError error;
+  JsonValue value;
+  value.m_value = JsonValue::api()->loadb(
+    static_cast<const char *>(m_buffer.data()) + start,
+    end - start,
+    json_flags(),
+    &error.m_value);
+  return m_callback(value, error, m_context);
+}
+
+void JsonIncrementalParser::compact() {
+  if (m_consumed == 0) {
+    return;
+  }
+
+  char *data = static_cast<char *>(m_buffer.data());
+  memmove(data, data + m_consumed, m_length - m_consumed);
+  m_length -= m_consumed;
+  m_scan_offset -= m_consumed;
+  if (m_value_start != npos) {
+    m_value_start -= m_consumed;
+  }
+  m_consumed = 0;
+}
@@ -0,0 +1,271 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#include <cstring>
+
+#include <fs/DataFile.hpp>
+
+#include "json/JsonLazyValue.hpp"
+
+#include "JsonScanner.hpp"
+
+using namespace var;
+using namespace json;
+
+JsonLazyValue JsonLazyIterator::operator*() const noexcept {
+  return m_value->at(m_index);
+}
+
+JsonLazyValue::JsonLazyValue(const var::StringView json) {
+  const JsonScanner scanner(json);
+  size_t start = scanner.skip_whitespace(0);
+  size_t end = json.length();
+  while (end > start && JsonScanner::is_whitespace(json.at(end - 1))) {
+    end--;
+  }
+  m_json = StringView(json.data() + start, end - start);
+  m_member_map = std::make_shared<MemberMap>();
+}
+
+JsonLazyValue::Type JsonLazyValue::type() const {
+  if (m_json.length() == 0) {
+    return Type::invalid;
+  }
+
+  switch (m_json.at(0)) {
+  case '{':
+    return Type::object;
+  case '[':
+    return Type::array;
+  case '"':
+    return Type::string;
+  case 't':
+    return Type::true_;
+  case 'f':
+    return Type::false_;
+  case 'n':
+    return Type::null;
+  default:
+    break;
+  }
+
+  for (size_t i = 0; i < m_json.length(); i++) {
+    const char c = m_json.at(i);
+    if (c == '.' || c == 'e' || c == 'E') {
+      return Type::real;
+    }
+  }
+  return Type::integer;
+}
+
+size_t JsonLazyValue::count() const { return member_list().count(); }
+
+JsonLazyValue JsonLazyValue::at(const var::StringView key) const {
+  API_RETURN_VALUE_IF_ERROR(JsonLazyValue());
+  if (!is_object()) {
+    return JsonLazyValue();
+  }
+
+  const char *data = m_json.data();
+  for (const auto &member : member_list()) {
+    const StringView member_key(data + member.key_offset, member.key_length);
+    if (member_key.find("\\") == StringView::npos) {
+      if (member_key == key) {
+        return member_value(member);
+      }
+      continue;
+    }
+
+    // escaped keys are rare, decode them with the parser
+    json_error_t error;
+    json_t *decoded = JsonValue::api()->loadb(
+      data + member.key_offset - 1,
+      member.key_length + 2,
+      JSON_DECODE_ANY,
+      &error);
+    if (decoded) {
+      const StringView decoded_key(
+        JsonValue::api()->string_value(decoded),
+        JsonValue::api()->string_length(decoded));
+      const bool is_match = decoded_key == key;
+      JsonValue::api()->decref(decoded);
+      if (is_match) {
+        return member_value(member);
+      }
+    }
+  }
+  return JsonLazyValue();
+}
+
+JsonLazyValue JsonLazyValue::at(size_t position) const {
+  API_RETURN_VALUE_IF_ERROR(JsonLazyValue());
+  const auto &list = member_list();
+  if (position >= list.count()) {
+    return JsonLazyValue();
+  }
+  return member_value(list.at(position));
+}
+
+var::StringView JsonLazyValue::key_at(size_t position) const {
+  API_RETURN_VALUE_IF_ERROR(StringView());
+  if (!is_object() || position >= member_list().count()) {
+    return StringView();
+  }
+  const auto &member = member_list().at(position);
+  return StringView(m_json.data() + member.key_offset, member.key_length);
+}
+
+JsonLazyValue
+JsonLazyValue::find(const var::StringView path, const char *delimiter) const {
+  const auto list = path.split(delimiter);
+  JsonLazyValue current = *this;
+
+  auto get_offset_from_string = [](var::StringView item) {
+    return StringView(item.data() + 1, item.length() - 2).to_unsigned_long();
+  };
+
+  for (const auto item : list) {
+    if (item.is_empty()) {
+      API_RETURN_VALUE_ASSIGN_ERROR(
+        JsonLazyValue(),
+        "empty item provided",
+        EINVAL);
+    }
+
+    JsonLazyValue next;
+    if (current.is_object()) {
+      next = current.at(item);
+      if (!next.is_valid() && item.length() > 2 && item.at(0) == '{') {
+        next = current.at(get_offset_from_string(item));
+      }
+    } else if (current.is_array()) {
+      if (item.length() < 3 || item.at(0) != '[') {
+        API_RETURN_VALUE_ASSIGN_ERROR(
+          JsonLazyValue(),
+          "array not specified []",
+          EINVAL);
+      }
+      next = current.at(get_offset_from_string(item));
+    }
+
+    API_RETURN_VALUE_IF_ERROR(JsonLazyValue());
+    if (!next.is_valid()) {
+      API_RETURN_VALUE_ASSIGN_ERROR(JsonLazyValue(), "invalid path", EINVAL);
+    }
+    current = next;
+  }
+  return current;
+}
+
+JsonValue JsonLazyValue::to_value() const {
+  API_RETURN_VALUE_IF_ERROR(JsonValue());
+  if (!is_valid()) {
+    return JsonValue();
+  }
+
+  json_error_t error;
+  JsonValue result;
+  result.m_value = JsonValue::api()->loadb(
+    m_json.data(),
+    m_json.length(),
+    JSON_DECODE_ANY,
+    &error);
+  if (result.m_value == nullptr) {
+    API_RETURN_VALUE_ASSIGN_ERROR(JsonValue(), "failed to parse json", EINVAL);
+  }
+  return result;
+}
+
+const var::Vector<JsonLazyValue::Member> &JsonLazyValue::member_list() const {
+  static const var::Vector<Member> empty_list;
+  if (m_member_list) {
+    return *m_member_list;
+  }
+
+  const bool is_object = this->is_object();
+  if (!is_object && !is_array()) {
+    return empty_list;
+  }
+
+  const auto iterator = m_member_map->find(m_json.data());
+  if (iterator != m_member_map->end()) {
+    m_member_list = &iterator->second;
+    return *m_member_list;
+  }
+
+  // references to map values stay valid when the map grows
+  auto &list = (*m_member_map)[m_json.data()];
+  m_member_list = &list;
+
+  const char close = is_object ? '}' : ']';
+  const JsonScanner scanner(m_json);
+  size_t position = scanner.skip_whitespace(1);
+  if (scanner.at(position) == close) {
+    return list;
+  }
+
+  while (true) {
+    Member member = {0, 0, 0, 0};
+    if (is_object) {
+      const size_t key_end = scanner.skip_string(position);
+      if (key_end == JsonScanner::npos) {
+        break;
+      }
+      member.key_offset = position + 1;
+      member.key_length = key_end - position - 2;
+      position = scanner.skip_whitespace(key_end);
+      if (scanner.at(position) != ':') {
+        break;
+      }
+      position = scanner.skip_whitespace(position + 1);
+    }
+
+    const size_t value_end = scanner.skip_value(position);
+    if (value_end == JsonScanner::npos) {
+      break;
+    }
+    member.value_offset = position;
+    member.value_length = value_end - position;
+    list.push_back(member);
+
+    position = scanner.skip_whitespace(value_end);
+    const char next = scanner.at(position);
+    if (next == close && position == m_json.length() - 1) {
+      return list;
+    }
+    if (next != ',') {
+      break;
+    }
+    position = scanner.skip_whitespace(position + 1);
+  }
+
+  list = var::Vector<Member>();
+  API_RETURN_VALUE_ASSIGN_ERROR(list, "invalid json", EINVAL);
+}
+
+JsonLazyValue JsonLazyValue::member_value(const Member &member) const {
+  JsonLazyValue result;
+  result.m_json
+    = StringView(m_json.data() + member.value_offset, member.value_length);
+  result.m_member_map = m_member_map;
+  return result;
+}
+
+JsonLazyDocument &JsonLazyDocument::load(const fs::FileObject &file) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  fs::DataFile data_file
+    = fs::DataFile().reserve(file.size()).write(file).move();
+  API_RETURN_VALUE_IF_ERROR(*this);
+  m_data = std::move(data_file.data());
+  const char *data = static_cast<const char *>(m_data.data());
+  m_root = JsonLazyValue(StringView(data, m_data.size()));
+  return *this;
+}
+
+JsonLazyDocument &JsonLazyDocument::from_string(const var::StringView json) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  m_data = Data(json.length());
+  memcpy(m_data.data(), json.data(), json.length());
+  const char *data = static_cast<const char *>(m_data.data());
+  m_root = JsonLazyValue(StringView(data, m_data.size()));
+  return *this;
+}
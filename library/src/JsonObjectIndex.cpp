@@ -0,0 +1,47 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#include "json/JsonObjectIndex.hpp"
+
+using namespace json;
+
+JsonObjectIndex::JsonObjectIndex(const JsonObject &object) : m_object(object) {
+  const auto &api = JsonValue::api();
+  const bool is_hashed = JsonValue::is_prehashed_key_supported();
+  json_t *value = const_cast<json_t *>(m_object.native_value());
+  m_key_list.reserve(m_object.count());
+  for (void *iter = api->object_iter(value); iter;
+       iter = api->object_iter_next(value, iter)) {
+    const var::StringView key = api->object_iter_key(iter);
+    m_key_list.push_back(
+      {m_key_buffer.length(),
+       key.length(),
+       is_hashed ? api->object_key_hash(key.data(), key.length()) : 0});
+    m_key_buffer.append(key);
+  }
+}
+
+JsonValue JsonObjectIndex::at(size_t offset) const {
+  if (offset >= m_key_list.count()) {
+    return JsonValue();
+  }
+  const auto &api = JsonValue::api();
+  const auto &key = m_key_list.at(offset);
+  const char *key_data = m_key_buffer.cstring() + key.offset;
+  // the key is looked up again in case the member was removed
+  return JsonValue(
+    JsonValue::is_prehashed_key_supported()
+      ? api->object_getn_hashed(
+        m_object.native_value(),
+        key_data,
+        key.length,
+        key.hash)
+      : api->object_getn(m_object.native_value(), key_data, key.length));
+}
+
+var::StringView JsonObjectIndex::key_at(size_t offset) const {
+  if (offset >= m_key_list.count()) {
+    return var::StringView();
+  }
+  const auto &key = m_key_list.at(offset);
+  return var::StringView(m_key_buffer.cstring() + key.offset, key.length);
+}
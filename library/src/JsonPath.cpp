@@ -0,0 +1,87 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#include "json/Json.hpp"
+#include "json/JsonPath.hpp"
+
+using namespace var;
+using namespace json;
+
+namespace {
+
+// returns false if value has anything other than digits
+bool parse_offset(const StringView value, size_t &offset) {
+  if (value.is_empty()) {
+    return false;
+  }
+  size_t result = 0;
+  for (size_t i = 0; i < value.length(); i++) {
+    const char c = value.at(i);
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    result = result * 10 + (c - '0');
+  }
+  offset = result;
+  return true;
+}
+
+} // namespace
+
+JsonPath::JsonPath(const var::StringView path, const char *delimiter)
+  : m_path(path) {
+  const StringView delimiter_view(delimiter);
+  const StringView input = m_path.string_view();
+
+  m_is_valid = true;
+  const bool is_hashed = JsonValue::is_prehashed_key_supported();
+  size_t start = 0;
+  if (
+    input.length() >= delimiter_view.length()
+    && StringView(input.data(), delimiter_view.length()) == delimiter_view) {
+    start = delimiter_view.length();
+  }
+
+  // "" and "/" are the value itself
+  if (start == input.length()) {
+    return;
+  }
+
+  while (start <= input.length()) {
+    size_t end = StringView(input.data() + start, input.length() - start)
+                   .find(delimiter_view);
+    end = end == StringView::npos ? input.length() : start + end;
+
+    const StringView item(input.data() + start, end - start);
+    if (item.is_empty()) {
+      m_is_valid = false;
+      m_step_list = var::Vector<Step>();
+      return;
+    }
+
+    Step step;
+    step.set_key_offset(start).set_key_length(item.length());
+    if (is_hashed) {
+      step.set_key_hash(
+        JsonValue::api()->object_key_hash(item.data(), item.length()));
+    }
+
+    const char first = item.at(0);
+    const char last = item.at(item.length() - 1);
+    size_t offset = 0;
+    const bool is_bracketed
+      = (first == '[' && last == ']') || (first == '{' && last == '}');
+    if (
+      item.length() > 2 && is_bracketed
+      && parse_offset(StringView(item.data() + 1, item.length() - 2), offset)) {
+      step.set_type(first == '[' ? Type::array_offset : Type::object_offset)
+        .set_offset(offset);
+      step.m_is_offset = true;
+    } else if (parse_offset(item, offset)) {
+      step.set_offset(offset);
+      step.m_is_offset = true;
+    }
+
+    m_step_list.push_back(step);
+    start = end + delimiter_view.length();
+  }
+}
@@ -0,0 +1,197 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#include "json/JsonPointer.hpp"
+
+using namespace var;
+using namespace json;
+
+namespace {
+
+// RFC 6901 array index: 0 or digits without a leading zero
+bool parse_index(const StringView value, size_t &index) {
+  if (value.is_empty() || (value.length() > 1 && value.at(0) == '0')) {
+    return false;
+  }
+  size_t result = 0;
+  for (size_t i = 0; i < value.length(); i++) {
+    const char c = value.at(i);
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    result = result * 10 + (c - '0');
+  }
+  index = result;
+  return true;
+}
+
+} // namespace
+
+JsonPointer::JsonPointer(const var::StringView pointer) : m_pointer(pointer) {
+  const StringView input = m_pointer.string_view();
+  if (input.is_empty()) {
+    // the whole document
+    m_is_valid = true;
+    return;
+  }
+
+  if (input.at(0) != '/') {
+    return;
+  }
+
+  Token token;
+  token.set_offset(0);
+  for (size_t i = 1; i <= input.length(); i++) {
+    if (i == input.length() || input.at(i) == '/') {
+      const StringView value(
+        m_token_string.cstring() + token.offset(),
+        m_token_string.length() - token.offset());
+      token.set_length(value.length());
+      size_t index = 0;
+      token.m_is_index = parse_index(value, index);
+      token.m_is_end = value == "-";
+      token.set_index(index);
+      m_token_list.push_back(token);
+
+      token = Token().set_offset(m_token_string.length());
+      continue;
+    }
+
+    char c = input.at(i);
+    if (c == '~') {
+      const char next = i + 1 < input.length() ? input.at(i + 1) : 0;
+      if (next != '0' && next != '1') {
+        m_token_list = var::Vector<Token>();
+        m_token_string.clear();
+        return;
+      }
+      c = next == '0' ? '~' : '/';
+      i++;
+    }
+    m_token_string.append(StringView(&c, 1));
+  }
+
+  m_is_valid = true;
+}
+
+var::String JsonPointer::escape(const var::StringView value) {
+  var::String result;
+  for (size_t i = 0; i < value.length(); i++) {
+    const char c = value.at(i);
+    if (c == '~') {
+      result.append("~0");
+    } else if (c == '/') {
+      result.append("~1");
+    } else {
+      result.append(StringView(&c, 1));
+    }
+  }
+  return result;
+}
+
+JsonValue JsonPointer::get(const JsonValue &root) const {
+  return JsonValue(
+    resolve(const_cast<json_t *>(root.m_value), count(), IsCreate::no));
+}
+
+JsonValue JsonPointer::create(JsonValue &root) const {
+  API_RETURN_VALUE_IF_ERROR(JsonValue());
+  return JsonValue(resolve(root.m_value, count(), IsCreate::yes));
+}
+
+const JsonPointer &
+JsonPointer::set(JsonValue &root, const JsonValue &value) const {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  if (is_valid() == false) {
+    API_RETURN_VALUE_ASSIGN_ERROR(*this, "invalid json pointer", EINVAL);
+  }
+
+  if (count() == 0) {
+    root = value;
+    return *this;
+  }
+
+  json_t *parent = resolve(root.m_value, count() - 1, IsCreate::yes);
+  API_RETURN_VALUE_IF_ERROR(*this);
+
+  const auto &last = m_token_list.back();
+  const auto key = token(count() - 1);
+  if (json_is_object(parent)) {
+    API_SYSTEM_CALL(
+      "",
+      JsonValue::api()
+        ->object_setn(parent, key.data(), key.length(), value.m_value));
+    return *this;
+  }
+
+  if (json_is_array(parent) == false) {
+    API_RETURN_VALUE_ASSIGN_ERROR(*this, "not an object or array", EINVAL);
+  }
+
+  const size_t size = JsonValue::api()->array_size(parent);
+  if (last.is_end() || (last.is_index() && last.index() == size)) {
+    API_SYSTEM_CALL("", JsonValue::api()->array_append(parent, value.m_value));
+  } else if (last.is_index() && last.index() < size) {
+    API_SYSTEM_CALL(
+      "",
+      JsonValue::api()->array_set(parent, last.index(), value.m_value));
+  } else {
+    API_RETURN_VALUE_ASSIGN_ERROR(*this, "array index out of range", EINVAL);
+  }
+  return *this;
+}
+
+json_t *
+JsonPointer::resolve(json_t *root, size_t count, IsCreate is_create) const {
+  if (is_valid() == false) {
+    if (is_create == IsCreate::yes) {
+      API_RETURN_VALUE_ASSIGN_ERROR(nullptr, "invalid json pointer", EINVAL);
+    }
+    return nullptr;
+  }
+
+  const auto &api = JsonValue::api();
+  json_t *current = root;
+  for (size_t i = 0; i < count && current; i++) {
+    const auto &value = m_token_list.at(i);
+    const auto key = token(i);
+
+    json_t *next = nullptr;
+    if (json_is_object(current)) {
+      next = api->object_getn(current, key.data(), key.length());
+    } else if (json_is_array(current)) {
+      if (value.is_index()) {
+        next = api->array_get(current, value.index());
+      }
+    } else if (is_create == IsCreate::yes) {
+      API_RETURN_VALUE_ASSIGN_ERROR(nullptr, "not an object or array", EINVAL);
+    }
+
+    if (next == nullptr && is_create == IsCreate::yes) {
+      const bool is_last = i + 1 == m_token_list.count();
+      const auto &child = is_last ? value : m_token_list.at(i + 1);
+      next = is_last ? api->create_null()
+             : (child.is_index() || child.is_end()) ? api->create_array()
+                                                    : api->create_object();
+
+      int result = -1;
+      if (json_is_object(current)) {
+        result = api->object_setn(current, key.data(), key.length(), next);
+      } else if (
+        value.is_end()
+        || (value.is_index() && value.index() == api->array_size(current))) {
+        result = api->array_append(current, next);
+      }
+      // the parent holds the reference
+      api->decref(next);
+
+      if (result < 0) {
+        API_RETURN_VALUE_ASSIGN_ERROR(
+          nullptr,
+          "failed to create value",
+          EINVAL);
+      }
+    }
+    current = next;
+  }
+  return current;
+}
@@ -0,0 +1,606 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#include <cstdlib>
+#include <cstring>
+
+#include "json/JsonQuery.hpp"
+
+using namespace var;
+using namespace json;
+
+namespace {
+
+void skip_whitespace(const char *&cursor, const char *end) {
+  while (cursor < end
+         && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n'
+             || *cursor == '\r')) {
+    cursor++;
+  }
+}
+
+bool is_name_end(char c) {
+  return strchr(" \t\r\n.[]()=!<>&|", c) != nullptr;
+}
+
+bool parse_long(const char *&cursor, const char *end, long &value) {
+  const char *start = cursor;
+  bool is_negative = false;
+  if (cursor < end && *cursor == '-') {
+    is_negative = true;
+    cursor++;
+  }
+  long result = 0;
+  const char *digits = cursor;
+  while (cursor < end && *cursor >= '0' && *cursor <= '9') {
+    result = result * 10 + (*cursor - '0');
+    cursor++;
+  }
+  if (cursor == digits) {
+    cursor = start;
+    return false;
+  }
+  value = is_negative ? -result : result;
+  return true;
+}
+
+int compare_string(const char *a, size_t a_length, const StringView b) {
+  const size_t length = a_length < b.length() ? a_length : b.length();
+  const int result = memcmp(a, b.data(), length);
+  if (result) {
+    return result;
+  }
+  return a_length == b.length() ? 0 : (a_length < b.length() ? -1 : 1);
+}
+
+} // namespace
+
+JsonQuery::JsonQuery(const var::StringView query) : m_query(query) {
+  m_is_valid = parse();
+  if (m_is_valid == false) {
+    m_step_list = var::Vector<Step>();
+    m_condition_list = var::Vector<Condition>();
+    m_key_list = var::Vector<Span>();
+  }
+}
+
+var::Vector<JsonValue> JsonQuery::find(const JsonValue &root) const {
+  var::Vector<JsonValue> result;
+  for_each(
+    root,
+    [](JsonRef value, void *context) {
+      static_cast<var::Vector<JsonValue> *>(context)->push_back(
+        value.to_value());
+      return true;
+    },
+    &result);
+  return result;
+}
+
+size_t JsonQuery::for_each(
+  const JsonValue &root,
+  Callback callback,
+  void *context) const {
+  API_RETURN_VALUE_IF_ERROR(0);
+  if (is_valid() == false) {
+    API_RETURN_VALUE_ASSIGN_ERROR(0, "invalid json query", EINVAL);
+  }
+
+  if (root.is_valid() == false) {
+    return 0;
+  }
+
+  // frames are popped from the back, so children are pushed in reverse
+  var::Vector<Frame> stack;
+  var::Vector<Frame> scratch;
+  stack.push_back({const_cast<json_t *>(root.native_value()), 0});
+
+  size_t count = 0;
+  while (stack.count()) {
+    const Frame frame = stack.back();
+    stack.pop_back();
+
+    if (frame.step == m_step_list.count()) {
+      count++;
+      if (callback(JsonRef(frame.value), context) == false) {
+        break;
+      }
+      continue;
+    }
+
+    scratch.clear();
+    expand(frame, scratch);
+    for (size_t i = scratch.count(); i > 0; i--) {
+      stack.push_back(scratch.at(i - 1));
+    }
+  }
+  return count;
+}
+
+void JsonQuery::expand(const Frame &frame, var::Vector<Frame> &scratch) const {
+  const auto &api = JsonValue::api();
+  const Step &step = m_step_list.at(frame.step);
+  json_t *value = frame.value;
+  const size_t next = frame.step + 1;
+
+  if (step.is_descendant) {
+    // each selected child is followed by a descent into that child
+    if (json_is_object(value)) {
+      for (void *iter = api->object_iter(value); iter;
+           iter = api->object_iter_next(value, iter)) {
+        json_t *child = api->object_iter_value(iter);
+        if (is_selected(step, api->object_iter_key(iter), 0, 0, child)) {
+          scratch.push_back({child, next});
+        }
+        if (json_is_object(child) || json_is_array(child)) {
+          scratch.push_back({child, frame.step});
+        }
+      }
+    } else if (json_is_array(value)) {
+      const size_t size = api->array_size(value);
+      for (size_t i = 0; i < size; i++) {
+        json_t *child = api->array_get(value, i);
+        if (is_selected(step, nullptr, i, size, child)) {
+          scratch.push_back({child, next});
+        }
+        if (json_is_object(child) || json_is_array(child)) {
+          scratch.push_back({child, frame.step});
+        }
+      }
+    }
+    return;
+  }
+
+  switch (step.type) {
+  case Type::key: {
+    const auto key = span(step.key);
+    json_t *child
+      = json_is_object(value)
+          ? api->object_getn(value, key.data(), key.length())
+          : nullptr;
+    if (child) {
+      scratch.push_back({child, next});
+    }
+    return;
+  }
+
+  case Type::offset: {
+    if (json_is_array(value) == false) {
+      return;
+    }
+    const long size = api->array_size(value);
+    const long offset = step.start < 0 ? step.start + size : step.start;
+    if (offset >= 0 && offset < size) {
+      scratch.push_back({api->array_get(value, offset), next});
+    }
+    return;
+  }
+
+  case Type::slice: {
+    if (json_is_array(value) == false) {
+      return;
+    }
+    const long size = api->array_size(value);
+    auto normalize = [size](long position, long low, long high) {
+      position = position < 0 ? position + size : position;
+      return position < low ? low : (position > high ? high : position);
+    };
+
+    if (step.step > 0) {
+      const long start = step.is_start ? normalize(step.start, 0, size) : 0;
+      const long end = step.is_end ? normalize(step.end, 0, size) : size;
+      for (long i = start; i < end; i += step.step) {
+        scratch.push_back({api->array_get(value, i), next});
+      }
+    } else {
+      const long start
+        = step.is_start ? normalize(step.start, -1, size - 1) : size - 1;
+      const long end = step.is_end ? normalize(step.end, -1, size - 1) : -1;
+      for (long i = start; i > end; i += step.step) {
+        scratch.push_back({api->array_get(value, i), next});
+      }
+    }
+    return;
+  }
+
+  case Type::wildcard:
+  case Type::filter:
+    if (json_is_object(value)) {
+      for (void *iter = api->object_iter(value); iter;
+           iter = api->object_iter_next(value, iter)) {
+        json_t *child = api->object_iter_value(iter);
+        if (step.type == Type::wildcard || is_match(step, child)) {
+          scratch.push_back({child, next});
+        }
+      }
+    } else if (json_is_array(value)) {
+      const size_t size = api->array_size(value);
+      for (size_t i = 0; i < size; i++) {
+        json_t *child = api->array_get(value, i);
+        if (step.type == Type::wildcard || is_match(step, child)) {
+          scratch.push_back({child, next});
+        }
+      }
+    }
+    return;
+  }
+}
+
+bool JsonQuery::is_selected(
+  const Step &step,
+  const char *key,
+  size_t index,
+  size_t size,
+  json_t *value) const {
+  switch (step.type) {
+  case Type::key:
+    return key && compare_string(key, strlen(key), span(step.key)) == 0;
+  case Type::wildcard:
+    return true;
+  case Type::offset:
+    return key == nullptr
+           && (step.start < 0 ? step.start + long(size) : step.start)
+                == long(index);
+  case Type::slice: {
+    if (key) {
+      return false;
+    }
+    const long position = index;
+    const long length = size;
+    const long start = step.is_start
+                         ? (step.start < 0 ? step.start + length : step.start)
+                         : (step.step > 0 ? 0 : length - 1);
+    const long end = step.is_end ? (step.end < 0 ? step.end + length : step.end)
+                                 : (step.step > 0 ? length : -1);
+    if (step.step > 0) {
+      return position >= start && position < end
+             && (position - start) % step.step == 0;
+    }
+    return position <= start && position > end
+           && (start - position) % -step.step == 0;
+  }
+  case Type::filter:
+    return is_match(step, value);
+  }
+  return false;
+}
+
+bool JsonQuery::is_match(const Step &step, json_t *value) const {
+  // conditions joined with && form groups, any group that matches is a match
+  bool is_group_match = true;
+  for (size_t i = 0; i < step.condition_count; i++) {
+    const auto &condition = m_condition_list.at(step.condition_offset + i);
+    is_group_match = is_group_match && is_match(condition, value);
+    if (condition.is_or || i + 1 == step.condition_count) {
+      if (is_group_match) {
+        return true;
+      }
+      is_group_match = true;
+    }
+  }
+  return false;
+}
+
+bool JsonQuery::is_match(const Condition &condition, json_t *value) const {
+  const auto &api = JsonValue::api();
+  for (size_t i = 0; i < condition.key_count && value; i++) {
+    const auto key = span(m_key_list.at(condition.key_offset + i));
+    value = json_is_object(value)
+              ? api->object_getn(value, key.data(), key.length())
+              : nullptr;
+  }
+
+  if (value == nullptr) {
+    return false;
+  }
+
+  if (condition.operation == Operation::exists) {
+    return true;
+  }
+
+  int result = 0;
+  bool is_same_type = false;
+  switch (condition.literal) {
+  case Literal::number:
+    is_same_type
+      = json_typeof(value) == JSON_INTEGER || json_typeof(value) == JSON_REAL;
+    if (is_same_type) {
+      const double number = api->number_value(value);
+      result = number < condition.number ? -1
+                                          : (number > condition.number ? 1 : 0);
+    }
+    break;
+  case Literal::string:
+    is_same_type = json_typeof(value) == JSON_STRING;
+    if (is_same_type) {
+      result = compare_string(
+        api->string_value(value),
+        api->string_length(value),
+        span(condition.string));
+    }
+    break;
+  case Literal::true_:
+    is_same_type = json_typeof(value) == JSON_TRUE;
+    break;
+  case Literal::false_:
+    is_same_type = json_typeof(value) == JSON_FALSE;
+    break;
+  case Literal::null:
+    is_same_type = json_typeof(value) == JSON_NULL;
+    break;
+  }
+
+  switch (condition.operation) {
+  case Operation::equal:
+    return is_same_type && result == 0;
+  case Operation::not_equal:
+    return !is_same_type || result != 0;
+  case Operation::less:
+    return is_same_type && result < 0;
+  case Operation::less_equal:
+    return is_same_type && result <= 0;
+  case Operation::greater:
+    return is_same_type && result > 0;
+  case Operation::greater_equal:
+    return is_same_type && result >= 0;
+  case Operation::exists:
+    break;
+  }
+  return true;
+}
+
+bool JsonQuery::parse() {
+  const char *cursor = m_query.cstring();
+  const char *end = cursor + m_query.length();
+
+  skip_whitespace(cursor, end);
+  if (cursor == end || *cursor != '$') {
+    return false;
+  }
+  cursor++;
+
+  while (cursor < end) {
+    Step step = {};
+    step.type = Type::key;
+    step.step = 1;
+
+    if (*cursor == '.') {
+      cursor++;
+      if (cursor < end && *cursor == '.') {
+        step.is_descendant = true;
+        cursor++;
+      }
+
+      if (cursor < end && *cursor == '[' && step.is_descendant) {
+        if (!parse_bracket(cursor, end, step)) {
+          return false;
+        }
+      } else if (cursor < end && *cursor == '*') {
+        step.type = Type::wildcard;
+        cursor++;
+      } else {
+        const char *start = cursor;
+        while (cursor < end && !is_name_end(*cursor)) {
+          cursor++;
+        }
+        if (cursor == start) {
+          return false;
+        }
+        step.key = {size_t(start - m_query.cstring()), size_t(cursor - start)};
+      }
+    } else if (*cursor == '[') {
+      if (!parse_bracket(cursor, end, step)) {
+        return false;
+      }
+    } else {
+      skip_whitespace(cursor, end);
+      if (cursor == end) {
+        break;
+      }
+      return false;
+    }
+
+    m_step_list.push_back(step);
+  }
+  return true;
+}
+
+bool JsonQuery::parse_bracket(
+  const char *&cursor,
+  const char *end,
+  Step &step) {
+  // cursor is on [
+  cursor++;
+  skip_whitespace(cursor, end);
+  if (cursor == end) {
+    return false;
+  }
+
+  if (*cursor == '*') {
+    step.type = Type::wildcard;
+    cursor++;
+  } else if (*cursor == '\'' || *cursor == '"') {
+    const char quote = *cursor++;
+    const char *start = cursor;
+    while (cursor < end && *cursor != quote) {
+      cursor++;
+    }
+    if (cursor == end) {
+      return false;
+    }
+    step.type = Type::key;
+    step.key = {size_t(start - m_query.cstring()), size_t(cursor - start)};
+    cursor++;
+  } else if (*cursor == '?') {
+    if (!parse_filter(cursor, end, step)) {
+      return false;
+    }
+  } else {
+    step.is_start = parse_long(cursor, end, step.start);
+    skip_whitespace(cursor, end);
+    if (cursor < end && *cursor == ':') {
+      step.type = Type::slice;
+      cursor++;
+      skip_whitespace(cursor, end);
+      step.is_end = parse_long(cursor, end, step.end);
+      skip_whitespace(cursor, end);
+      if (cursor < end && *cursor == ':') {
+        cursor++;
+        skip_whitespace(cursor, end);
+        if (parse_long(cursor, end, step.step) && step.step == 0) {
+          return false;
+        }
+      }
+    } else if (step.is_start) {
+      step.type = Type::offset;
+    } else {
+      return false;
+    }
+  }
+
+  skip_whitespace(cursor, end);
+  if (cursor == end || *cursor != ']') {
+    return false;
+  }
+  cursor++;
+  return true;
+}
+
+bool JsonQuery::parse_filter(
+  const char *&cursor,
+  const char *end,
+  Step &step) {
+  // cursor is on ?
+  cursor++;
+  skip_whitespace(cursor, end);
+  if (cursor == end || *cursor != '(') {
+    return false;
+  }
+  cursor++;
+
+  step.type = Type::filter;
+  step.condition_offset = m_condition_list.count();
+  do {
+    skip_whitespace(cursor, end);
+    if (!parse_condition(cursor, end)) {
+      return false;
+    }
+    skip_whitespace(cursor, end);
+    if (
+      end - cursor >= 2
+      && (!strncmp(cursor, "&&", 2) || !strncmp(cursor, "||", 2))) {
+      m_condition_list.back().is_or = *cursor == '|';
+      cursor += 2;
+      continue;
+    }
+    break;
+  } while (true);
+
+  step.condition_count = m_condition_list.count() - step.condition_offset;
+  if (cursor == end || *cursor != ')') {
+    return false;
+  }
+  cursor++;
+  return true;
+}
+
+bool JsonQuery::parse_condition(const char *&cursor, const char *end) {
+  if (cursor == end || *cursor != '@') {
+    return false;
+  }
+  cursor++;
+
+  Condition condition = {};
+  condition.key_offset = m_key_list.count();
+  while (cursor < end && *cursor == '.') {
+    const char *start = ++cursor;
+    while (cursor < end && !is_name_end(*cursor)) {
+      cursor++;
+    }
+    if (cursor == start) {
+      return false;
+    }
+    m_key_list.push_back(
+      {size_t(start - m_query.cstring()), size_t(cursor - start)});
+  }
+  condition.key_count = m_key_list.count() - condition.key_offset;
+
+  skip_whitespace(cursor, end);
+  struct {
+    const char *text;
+    Operation operation;
+  } const operation_list[] = {
+    {"==", Operation::equal},
+    {"!=", Operation::not_equal},
+    {"<=", Operation::less_equal},
+    {">=", Operation::greater_equal},
+    {"<", Operation::less},
+    {">", Operation::greater}};
+
+  condition.operation = Operation::exists;
+  for (const auto &item : operation_list) {
+    const size_t length = strlen(item.text);
+    if (size_t(end - cursor) >= length && !strncmp(cursor, item.text, length)) {
+      condition.operation = item.operation;
+      cursor += length;
+      break;
+    }
+  }
+
+  if (condition.operation != Operation::exists) {
+    skip_whitespace(cursor, end);
+    if (cursor == end) {
+      return false;
+    }
+
+    if (*cursor == '\'' || *cursor == '"') {
+      const char quote = *cursor++;
+      const char *start = cursor;
+      while (cursor < end && *cursor != quote) {
+        cursor++;
+      }
+      if (cursor == end) {
+        return false;
+      }
+      condition.literal = Literal::string;
+      condition.string
+        = {size_t(start - m_query.cstring()), size_t(cursor - start)};
+      cursor++;
+    } else if (*cursor == '-' || (*cursor >= '0' && *cursor <= '9')) {
+      // the query is null terminated so strtod() can't read past end
+      char *number_end = nullptr;
+      condition.literal = Literal::number;
+      condition.number = strtod(cursor, &number_end);
+      if (number_end == cursor || number_end > end) {
+        return false;
+      }
+      cursor = number_end;
+    } else {
+      struct {
+        const char *text;
+        Literal literal;
+      } const literal_list[]
+        = {{"true", Literal::true_},
+           {"false", Literal::false_},
+           {"null", Literal::null}};
+
+      bool is_found = false;
+      for (const auto &item : literal_list) {
+        const size_t length = strlen(item.text);
+        if (
+          size_t(end - cursor) >= length
+          && !strncmp(cursor, item.text, length)) {
+          condition.literal = item.literal;
+          cursor += length;
+          is_found = true;
+          break;
+        }
+      }
+      if (!is_found) {
+        return false;
+      }
+    }
+  }
+
+  m_condition_list.push_back(condition);
+  return true;
+}
@@ -0,0 +1,190 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#include <cstdint>
+#include <cstring>
+
+#include <var/Data.hpp>
+
+#include "rapidjson/error/en.h"
+#include "rapidjson/memorystream.h"
+#include "rapidjson/reader.h"
+
+#include "json/JsonReader.hpp"
+
+using namespace var;
+using namespace json;
+
+namespace {
+
+// rapidjson input stream that pulls from an fs::FileObject
+class FileObjectReadStream {
+public:
+  typedef char Ch;
+
+  FileObjectReadStream(const fs::FileObject &file, var::View buffer)
+    : m_file(file), m_buffer(buffer.to_char()), m_buffer_size(buffer.size()),
+      m_current(m_buffer) {
+    read();
+  }
+
+  Ch Peek() const { return *m_current; }
+  Ch Take() {
+    const Ch c = *m_current;
+    read();
+    return c;
+  }
+  size_t Tell() const { return m_count + (m_current - m_buffer); }
+
+  Ch *PutBegin() {
+    RAPIDJSON_ASSERT(false);
+    return nullptr;
+  }
+  void Put(Ch) { RAPIDJSON_ASSERT(false); }
+  void Flush() { RAPIDJSON_ASSERT(false); }
+  size_t PutEnd(Ch *) {
+    RAPIDJSON_ASSERT(false);
+    return 0;
+  }
+
+private:
+  const fs::FileObject &m_file;
+  Ch *m_buffer;
+  size_t m_buffer_size;
+  Ch *m_current;
+  Ch *m_last = nullptr;
+  size_t m_read_count = 0;
+  size_t m_count = 0;
+  bool m_is_eof = false;
+
+  void read() {
+    if (m_current < m_last) {
+      ++m_current;
+      return;
+    }
+
+    if (m_is_eof) {
+      return;
+    }
+
+    m_count += m_read_count;
+    // one byte is reserved for the terminating null
+    const int result
+      = m_file.read(View(m_buffer, m_buffer_size - 1)).return_value();
+    m_read_count = result > 0 ? result : 0;
+    m_current = m_buffer;
+    m_last = m_buffer + m_read_count - 1;
+    if (m_read_count < m_buffer_size - 1) {
+      m_buffer[m_read_count] = '\0';
+      ++m_last;
+      m_is_eof = true;
+    }
+  }
+};
+
+class HandlerAdapter {
+public:
+  explicit HandlerAdapter(JsonReader::Handler &handler) : m_handler(handler) {}
+
+  bool Null() { return m_handler.null(); }
+  bool Bool(bool value) { return m_handler.boolean(value); }
+  bool Int(int value) { return m_handler.integer(value); }
+  bool Uint(unsigned value) { return m_handler.integer(value); }
+  bool Int64(int64_t value) { return m_handler.integer(value); }
+  bool Uint64(uint64_t value) {
+    return value > INT64_MAX ? m_handler.real(value)
+                             : m_handler.integer(static_cast<s64>(value));
+  }
+  bool Double(double value) { return m_handler.real(value); }
+  bool RawNumber(const char *value, rapidjson::SizeType length, bool) {
+    return m_handler.string(StringView(value, length));
+  }
+  bool String(const char *value, rapidjson::SizeType length, bool) {
+    return m_handler.string(StringView(value, length));
+  }
+
+  bool StartObject() { return m_handler.start_object(); }
+  bool Key(const char *value, rapidjson::SizeType length, bool) {
+    return m_handler.key(StringView(value, length));
+  }
+  bool EndObject(rapidjson::SizeType count) {
+    return m_handler.end_object(count);
+  }
+
+  bool StartArray() { return m_handler.start_array(); }
+  bool EndArray(rapidjson::SizeType count) {
+    return m_handler.end_array(count);
+  }
+
+private:
+  JsonReader::Handler &m_handler;
+};
+
+// the iterative parser keeps its own stack so the call depth doesn't grow
+// with the nesting depth of the input
+constexpr unsigned parse_flags
+  = rapidjson::kParseIterativeFlag | rapidjson::kParseValidateEncodingFlag;
+
+template <class Stream>
+rapidjson::ParseResult parse_stream(
+  Stream &stream,
+  JsonReader::Handler &handler,
+  JsonReader::Flags flags) {
+  rapidjson::Reader reader;
+  HandlerAdapter adapter(handler);
+  if (flags & JsonReader::Flags::disable_eof_check) {
+    return reader.Parse<parse_flags | rapidjson::kParseStopWhenDoneFlag>(
+      stream,
+      adapter);
+  }
+  return reader.Parse<parse_flags>(stream, adapter);
+}
+
+} // namespace
+
+JsonReader &JsonReader::parse(const var::StringView json, Handler &handler) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  rapidjson::MemoryStream stream(json.data(), json.length());
+  const auto result = parse_stream(stream, handler, option_flags());
+  m_position = stream.Tell();
+  return update_error(
+    result.Code(),
+    result.Offset(),
+    rapidjson::GetParseError_En(result.Code()),
+    "<string>");
+}
+
+JsonReader &
+JsonReader::parse(const fs::FileObject &file, Handler &handler) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  // the stream needs at least four bytes to detect the end of input
+  var::Data buffer(m_buffer_size > 4 ? m_buffer_size : 4);
+  FileObjectReadStream stream(file, buffer);
+  const auto result = parse_stream(stream, handler, option_flags());
+  m_position = stream.Tell();
+  return update_error(
+    result.Code(),
+    result.Offset(),
+    rapidjson::GetParseError_En(result.Code()),
+    "<stream>");
+}
+
+JsonReader &JsonReader::update_error(
+  int code,
+  size_t offset,
+  const char *text,
+  const char *source) {
+  m_error = JsonError();
+  // a handler returning false stops the parser without an error
+  if (
+    code == rapidjson::kParseErrorNone
+    || code == rapidjson::kParseErrorTermination) {
+    return *this;
+  }
+
+  m_error.m_value.line = -1;
+  m_error.m_value.column = -1;
+  m_error.m_value.position = offset;
+  strncpy(m_error.m_value.text, text, sizeof(m_error.m_value.text) - 1);
+  strncpy(m_error.m_value.source, source, sizeof(m_error.m_value.source) - 1);
+  API_RETURN_VALUE_ASSIGN_ERROR(*this, "failed to parse json", EINVAL);
+}
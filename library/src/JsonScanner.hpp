@@ -0,0 +1,249 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#ifndef JSONAPI_JSONSCANNER_HPP
+#define JSONAPI_JSONSCANNER_HPP
+
+#include <cstring>
+
+#if defined __AVX2__
+#include <immintrin.h>
+#elif defined __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <var/StringView.hpp>
+
+namespace json {
+
+// Finds the extent of values in JSON text without decoding them. Only the
+// structure is checked; values are fully validated when they are parsed.
+class JsonScanner {
+public:
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  explicit JsonScanner(const var::StringView input)
+    : m_data(input.data()), m_length(input.length()) {}
+
+  size_t length() const { return m_length; }
+  char at(size_t position) const {
+    return position < m_length ? m_data[position] : 0;
+  }
+
+  size_t skip_whitespace(size_t position) const {
+    while (position < m_length && is_whitespace(m_data[position])) {
+      position++;
+    }
+    return position;
+  }
+
+  // position is the opening quote, returns the offset after the closing quote
+  size_t skip_string(size_t position) const {
+    if (at(position) != '"') {
+      return npos;
+    }
+    for (position++; position < m_length; position++) {
+      const char c = m_data[position];
+      if (c == '\\') {
+        position++;
+      } else if (c == '"') {
+        return position + 1;
+      }
+    }
+    return npos;
+  }
+
+  // position is the first character of a value, returns the offset after it
+  size_t skip_value(size_t position) const {
+    const char c = at(position);
+    if (c == '"') {
+      return skip_string(position);
+    }
+
+    if (c == '{' || c == '[') {
+      size_t depth = 0;
+      while (position < m_length) {
+        const char next = m_data[position];
+        if (next == '"') {
+          position = skip_string(position);
+          if (position == npos) {
+            return npos;
+          }
+          continue;
+        }
+        if (next == '{' || next == '[') {
+          depth++;
+        } else if (next == '}' || next == ']') {
+          if (--depth == 0) {
+            return position + 1;
+          }
+        }
+        position++;
+      }
+      return npos;
+    }
+
+    // literal or number
+    const size_t start = position;
+    while (position < m_length && !is_delimiter(m_data[position])) {
+      position++;
+    }
+    return position == start ? npos : position;
+  }
+
+  static bool is_whitespace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+  }
+
+  static bool is_delimiter(char c) {
+    return is_whitespace(c) || c == ',' || c == ':' || c == '}' || c == ']'
+           || c == '{' || c == '[' || c == '"';
+  }
+
+private:
+  const char *m_data;
+  size_t m_length;
+};
+
+
+// Finds the structural characters ({ } [ ] : ,) outside of strings and the
+// unescaped quotes 64 bytes at a time. Quotes, backslashes and structural
+// characters are classified into bit masks (SSE2/AVX2 when available, a byte
+// loop otherwise) and the string state is carried between blocks and calls,
+// so the input can be split anywhere.
+class JsonStructuralScanner {
+public:
+  static constexpr size_t block_size = 64;
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  // callback(offset, c) is called in order, quotes are reported at both ends
+  // of a string; returns the offset where callback returned false or npos
+  template <class Callback>
+  size_t scan(const char *data, size_t length, Callback &&callback) {
+    char padded[block_size];
+    for (size_t start = 0; start < length; start += block_size) {
+      const char *block = data + start;
+      const size_t remaining = length - start;
+      if (remaining < block_size) {
+        memset(padded, ' ', block_size);
+        memcpy(padded, block, remaining);
+        block = padded;
+      }
+
+      u64 quote, backslash, op;
+      classify(block, quote, backslash, op);
+
+      quote &= ~find_escaped(backslash);
+      const u64 in_string = prefix_xor(quote) ^ m_string_carry;
+      m_string_carry = static_cast<u64>(static_cast<s64>(in_string) >> 63);
+
+      u64 events = (op & ~in_string) | quote;
+      while (events) {
+        const size_t offset = start + __builtin_ctzll(events);
+        if (!callback(offset, data[offset])) {
+          return offset;
+        }
+        events &= events - 1;
+      }
+    }
+    return npos;
+  }
+
+  void reset() {
+    m_escape_carry = 0;
+    m_string_carry = 0;
+  }
+
+private:
+  // 1 if the first byte of the next block is escaped
+  u64 m_escape_carry = 0;
+  // all ones if the last block ended inside a string
+  u64 m_string_carry = 0;
+
+  static u64 prefix_xor(u64 value) {
+    value ^= value << 1;
+    value ^= value << 2;
+    value ^= value << 4;
+    value ^= value << 8;
+    value ^= value << 16;
+    value ^= value << 32;
+    return value;
+  }
+
+  // backslashes are rare so they are resolved one at a time
+  u64 find_escaped(u64 backslash) {
+    u64 escaped = m_escape_carry;
+    m_escape_carry = 0;
+    backslash &= ~escaped;
+    while (backslash) {
+      const u64 bit = backslash & (~backslash + 1);
+      if (bit == u64(1) << 63) {
+        m_escape_carry = 1;
+      } else {
+        escaped |= bit << 1;
+      }
+      backslash &= ~(bit | (bit << 1));
+    }
+    return escaped;
+  }
+
+  static void classify(const char *block, u64 &quote, u64 &backslash, u64 &op) {
+#if defined __AVX2__
+    quote = backslash = op = 0;
+    for (size_t i = 0; i < block_size; i += 32) {
+      const __m256i input
+        = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + i));
+      // [ and { (also ] and }) only differ by 0x20
+      const __m256i folded = _mm256_or_si256(input, _mm256_set1_epi8(0x20));
+      const __m256i is_op = _mm256_or_si256(
+        _mm256_or_si256(
+          _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')),
+          _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}'))),
+        _mm256_or_si256(
+          _mm256_cmpeq_epi8(input, _mm256_set1_epi8(',')),
+          _mm256_cmpeq_epi8(input, _mm256_set1_epi8(':'))));
+      quote |= u64(u32(_mm256_movemask_epi8(
+                 _mm256_cmpeq_epi8(input, _mm256_set1_epi8('"')))))
+               << i;
+      backslash |= u64(u32(_mm256_movemask_epi8(
+                     _mm256_cmpeq_epi8(input, _mm256_set1_epi8('\\')))))
+                   << i;
+      op |= u64(u32(_mm256_movemask_epi8(is_op))) << i;
+    }
+#elif defined __SSE2__
+    quote = backslash = op = 0;
+    for (size_t i = 0; i < block_size; i += 16) {
+      const __m128i input
+        = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i));
+      // [ and { (also ] and }) only differ by 0x20
+      const __m128i folded = _mm_or_si128(input, _mm_set1_epi8(0x20));
+      const __m128i is_op = _mm_or_si128(
+        _mm_or_si128(
+          _mm_cmpeq_epi8(folded, _mm_set1_epi8('{')),
+          _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))),
+        _mm_or_si128(
+          _mm_cmpeq_epi8(input, _mm_set1_epi8(',')),
+          _mm_cmpeq_epi8(input, _mm_set1_epi8(':'))));
+      quote |= u64(_mm_movemask_epi8(
+                 _mm_cmpeq_epi8(input, _mm_set1_epi8('"'))))
+               << i;
+      backslash |= u64(_mm_movemask_epi8(
+                     _mm_cmpeq_epi8(input, _mm_set1_epi8('\\'))))
+                   << i;
+      op |= u64(_mm_movemask_epi8(is_op)) << i;
+    }
+#else
+    quote = backslash = op = 0;
+    for (size_t i = 0; i < block_size; i++) {
+      const char c = block[i];
+      const char folded = c | 0x20;
+      quote |= u64(c == '"') << i;
+      backslash |= u64(c == '\\') << i;
+      op |= u64(folded == '{' || folded == '}' || c == ',' || c == ':') << i;
+    }
+#endif
+  }
+};
+
+} // namespace json
+
+#endif // JSONAPI_JSONSCANNER_HPP
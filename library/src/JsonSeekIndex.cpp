@@ -0,0 +1,300 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <fs/DataFile.hpp>
+#include <var/Data.hpp>
+
+#include "json/JsonSeekIndex.hpp"
+
+#include "JsonScanner.hpp"
+
+using namespace var;
+using namespace json;
+
+namespace {
+
+#if defined __link
+constexpr size_t build_buffer_size = 64 * 1024;
+#else
+constexpr size_t build_buffer_size = 256;
+#endif
+
+constexpr size_t npos = JsonStructuralScanner::npos;
+constexpr const char *header = "JsonSeekIndex 1 ";
+
+int compare_path(const StringView a, const StringView b) {
+  const size_t length = a.length() < b.length() ? a.length() : b.length();
+  const int result = memcmp(a.data(), b.data(), length);
+  if (result) {
+    return result;
+  }
+  return a.length() == b.length() ? 0 : (a.length() < b.length() ? -1 : 1);
+}
+
+// "list//[3]/" is "/list/[3]"
+var::String normalize_path(const StringView path) {
+  var::String result;
+  for (const auto item : path.split("/")) {
+    if (item.is_empty() == false) {
+      result.append("/").append(item);
+    }
+  }
+  return result.is_empty() ? var::String("/") : result;
+}
+
+StringView next_field(StringView &line) {
+  const size_t space = line.find(" ");
+  if (space == StringView::npos) {
+    const StringView result = line;
+    line = StringView();
+    return result;
+  }
+  const StringView result(line.data(), space);
+  line = StringView(line.data() + space + 1, line.length() - space - 1);
+  return result;
+}
+
+} // namespace
+
+JsonSeekIndex &JsonSeekIndex::build(const fs::FileObject &file) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+
+  struct Container {
+    bool is_object;
+    size_t index;
+    // position in m_entry_list or npos if it isn't indexed
+    size_t entry;
+  };
+
+  m_entry_list = var::Vector<Entry>();
+  m_source_size = file.size();
+
+  var::Vector<Container> container_list;
+  var::String key;
+  bool is_string = false;
+  bool is_key = false;
+  bool is_expecting_key = false;
+  // keys are only kept for the children of indexed containers
+  bool is_recording = false;
+  size_t key_start = 0;
+
+  var::Data buffer(build_buffer_size);
+  JsonStructuralScanner scanner;
+
+  do {
+    const size_t location = file.location();
+    const int read_result = file.read(buffer).return_value();
+    if (read_result <= 0) {
+      break;
+    }
+
+    const char *data = static_cast<const char *>(buffer.data());
+    const size_t length = read_result;
+    key_start = 0;
+
+    scanner.scan(data, length, [&](size_t offset, char c) {
+      switch (c) {
+      case '"':
+        is_string = !is_string;
+        if (is_string) {
+          is_key = is_expecting_key;
+          is_recording = is_key && container_list.back().entry != npos
+                         && container_list.count() <= m_maximum_depth;
+          if (is_recording) {
+            key.clear();
+            key_start = offset + 1;
+          }
+        } else if (is_key) {
+          is_key = false;
+          is_expecting_key = false;
+          if (is_recording) {
+            key.append(StringView(data + key_start, offset - key_start));
+            is_recording = false;
+          }
+        }
+        return true;
+
+      case ',':
+        if (container_list.count()) {
+          if (container_list.back().is_object) {
+            is_expecting_key = true;
+          } else {
+            container_list.back().index++;
+          }
+        }
+        return true;
+
+      case '{':
+      case '[': {
+        const size_t depth = container_list.count();
+        size_t entry = npos;
+        if (
+          depth <= m_maximum_depth
+          && (depth == 0 || container_list.back().entry != npos)) {
+          var::String path;
+          if (depth) {
+            const auto &parent = container_list.back();
+            path = m_entry_list.at(parent.entry).path();
+            if (depth > 1) {
+              path.append("/");
+            }
+            if (parent.is_object) {
+              path.append(key);
+            } else {
+              char index[24];
+              snprintf(
+                index,
+                sizeof(index),
+                "[%llu]",
+                static_cast<unsigned long long>(parent.index));
+              path.append(index);
+            }
+          } else {
+            path = var::String("/");
+          }
+
+          m_entry_list.push_back(
+            Entry().set_path(path).set_start(location + offset));
+          entry = m_entry_list.count() - 1;
+        }
+        container_list.push_back({c == '{', 0, entry});
+        is_expecting_key = c == '{';
+        return true;
+      }
+
+      case '}':
+      case ']':
+        if (container_list.count()) {
+          const size_t entry = container_list.back().entry;
+          if (entry != npos) {
+            m_entry_list.at(entry).set_end(location + offset + 1);
+          }
+          container_list.pop_back();
+        }
+        is_expecting_key = false;
+        return true;
+
+      default:
+        // ':'
+        return true;
+      }
+    });
+
+    if (is_recording) {
+      // the key continues in the next read
+      key.append(StringView(data + key_start, length - key_start));
+    }
+  } while (true);
+
+  sort();
+  return *this;
+}
+
+const JsonSeekIndex &JsonSeekIndex::save(const fs::FileObject &file) const {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  char line[64];
+  snprintf(
+    line,
+    sizeof(line),
+    "%s%llu %llu\n",
+    header,
+    static_cast<unsigned long long>(m_maximum_depth),
+    static_cast<unsigned long long>(m_source_size));
+
+  var::String output(line);
+  for (const auto &entry : m_entry_list) {
+    snprintf(
+      line,
+      sizeof(line),
+      "%llu %llu ",
+      static_cast<unsigned long long>(entry.start()),
+      static_cast<unsigned long long>(entry.end()));
+    output.append(line).append(entry.path()).append("\n");
+    if (output.length() >= build_buffer_size) {
+      file.write(output);
+      output.clear();
+    }
+  }
+  file.write(output);
+  return *this;
+}
+
+JsonSeekIndex &JsonSeekIndex::load(const fs::FileObject &file) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  fs::DataFile data_file
+    = fs::DataFile().reserve(file.size()).write(file).move();
+  API_RETURN_VALUE_IF_ERROR(*this);
+
+  m_entry_list = var::Vector<Entry>();
+  StringView input(
+    static_cast<const char *>(data_file.data().data()),
+    data_file.data().size());
+
+  bool is_header = true;
+  while (input.length()) {
+    const size_t end = input.find("\n");
+    if (end == StringView::npos) {
+      break;
+    }
+    StringView line(input.data(), end);
+    input = StringView(input.data() + end + 1, input.length() - end - 1);
+
+    if (is_header) {
+      const size_t header_length = strlen(header);
+      if (
+        line.length() < header_length
+        || StringView(line.data(), header_length) != header) {
+        API_RETURN_VALUE_ASSIGN_ERROR(*this, "invalid seek index", EINVAL);
+      }
+      line = StringView(
+        line.data() + header_length,
+        line.length() - header_length);
+      m_maximum_depth = next_field(line).to_unsigned_long();
+      m_source_size = next_field(line).to_unsigned_long();
+      is_header = false;
+      continue;
+    }
+
+    const size_t start = next_field(line).to_unsigned_long();
+    const size_t entry_end = next_field(line).to_unsigned_long();
+    m_entry_list.push_back(
+      Entry().set_path(var::String(line)).set_start(start).set_end(entry_end));
+  }
+
+  if (is_header) {
+    API_RETURN_VALUE_ASSIGN_ERROR(*this, "invalid seek index", EINVAL);
+  }
+
+  sort();
+  return *this;
+}
+
+JsonSeekIndex::Entry JsonSeekIndex::find(const var::StringView path) const {
+  const var::String key = normalize_path(path);
+  const auto result = std::lower_bound(
+    m_entry_list.begin(),
+    m_entry_list.end(),
+    key,
+    [](const Entry &entry, const var::String &value) {
+      return compare_path(entry.path(), value) < 0;
+    });
+
+  if (
+    result != m_entry_list.end() && compare_path(result->path(), key) == 0) {
+    return *result;
+  }
+  return Entry();
+}
+
+void JsonSeekIndex::sort() {
+  // stable so repeated paths (JSON Lines) stay in file order
+  std::stable_sort(
+    m_entry_list.begin(),
+    m_entry_list.end(),
+    [](const Entry &a, const Entry &b) {
+      return compare_path(a.path(), b.path()) < 0;
+    });
+}
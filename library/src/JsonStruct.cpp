@@ -0,0 +1,155 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#include "json/JsonStruct.hpp"
+
+using namespace var;
+using namespace json;
+
+namespace {
+
+// routes reader events to the fields of the struct being read
+class Binder : public JsonReader::Handler {
+public:
+  explicit Binder(const JsonStruct::Target &target) : m_pending(target) {}
+
+  bool is_type_error() const { return m_is_type_error; }
+
+  bool null() override {
+    // null leaves the field as it is, in an array next() has already
+    // appended T()
+    next();
+    return true;
+  }
+
+  bool boolean(bool value) override {
+    return !next() || set(m_pending.binding->boolean, value);
+  }
+
+  bool integer(s64 value) override {
+    return !next() || set(m_pending.binding->integer, value);
+  }
+
+  bool real(double value) override {
+    return !next() || set(m_pending.binding->real, value);
+  }
+
+  bool string(const var::StringView value) override {
+    return !next() || set(m_pending.binding->string, value);
+  }
+
+  bool start_object() override {
+    if (!next()) {
+      m_skip_depth++;
+      return true;
+    }
+    if (m_pending.binding->key == nullptr) {
+      return type_error();
+    }
+    m_container_list.push_back({m_pending, true});
+    return true;
+  }
+
+  bool key(const var::StringView key) override {
+    if (m_skip_depth) {
+      return true;
+    }
+    const auto &object = m_container_list.back().target;
+    if (!object.binding->key(object.value, key, m_pending)) {
+      // the value is skipped
+      m_pending.binding = nullptr;
+    }
+    return true;
+  }
+
+  bool end_object(size_t count) override { return end_container(); }
+
+  bool start_array() override {
+    if (!next()) {
+      m_skip_depth++;
+      return true;
+    }
+    if (m_pending.binding->element == nullptr) {
+      return type_error();
+    }
+    m_pending.binding->start_array(m_pending.value);
+    m_container_list.push_back({m_pending, false});
+    return true;
+  }
+
+  bool end_array(size_t count) override { return end_container(); }
+
+private:
+  struct Container {
+    JsonStruct::Target target;
+    bool is_object;
+  };
+
+  JsonStruct::Target m_pending;
+  var::Vector<Container> m_container_list;
+  // depth inside a value that is being skipped
+  size_t m_skip_depth = 0;
+  bool m_is_type_error = false;
+
+  // false if the next value is skipped
+  bool next() {
+    if (m_skip_depth) {
+      return false;
+    }
+    if (m_container_list.count() && !m_container_list.back().is_object) {
+      const auto &array = m_container_list.back().target;
+      array.binding->element(array.value, m_pending);
+    }
+    return m_pending.binding != nullptr;
+  }
+
+  template <typename Function, typename Value>
+  bool set(Function function, Value value) {
+    if (function == nullptr || !function(m_pending.value, value)) {
+      return type_error();
+    }
+    return true;
+  }
+
+  bool type_error() {
+    m_is_type_error = true;
+    return false;
+  }
+
+  bool end_container() {
+    if (m_skip_depth) {
+      m_skip_depth--;
+      return true;
+    }
+    m_container_list.pop_back();
+    return true;
+  }
+};
+
+} // namespace
+
+JsonStruct &
+JsonStruct::read(const var::StringView json, const Target &target) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  Binder binder(target);
+  m_reader.parse(json, binder);
+  return update_error(binder.is_type_error());
+}
+
+JsonStruct &
+JsonStruct::read(const fs::FileObject &file, const Target &target) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  Binder binder(target);
+  m_reader.parse(file, binder);
+  return update_error(binder.is_type_error());
+}
+
+JsonStruct &JsonStruct::update_error(bool is_type_error) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  if (is_type_error) {
+    API_RETURN_VALUE_ASSIGN_ERROR(
+      *this,
+      "json value has the wrong type",
+      EINVAL);
+  }
+  return *this;
+}
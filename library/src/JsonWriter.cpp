@@ -0,0 +1,413 @@
+// Copyright 2016-2021 Tyler Gilbert and Stratify Labs, Inc; see LICENSE.md
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "json/JsonWriter.hpp"
+
+using namespace var;
+using namespace json;
+
+namespace {
+
+// decodes one UTF-8 sequence, returns the number of bytes used or 0
+size_t decode_utf8(const char *input, size_t length, u32 &codepoint) {
+  const u8 first = input[0];
+  size_t count;
+  if (first < 0x80) {
+    codepoint = first;
+    return 1;
+  } else if ((first & 0xe0) == 0xc0) {
+    codepoint = first & 0x1f;
+    count = 2;
+  } else if ((first & 0xf0) == 0xe0) {
+    codepoint = first & 0x0f;
+    count = 3;
+  } else if ((first & 0xf8) == 0xf0) {
+    codepoint = first & 0x07;
+    count = 4;
+  } else {
+    return 0;
+  }
+
+  if (count > length) {
+    return 0;
+  }
+
+  for (size_t i = 1; i < count; i++) {
+    const u8 next = input[i];
+    if ((next & 0xc0) != 0x80) {
+      return 0;
+    }
+    codepoint = (codepoint << 6) | (next & 0x3f);
+  }
+  return count;
+}
+
+// same format as jansson's dumper so output matches JsonDocument
+size_t format_real(char *buffer, size_t size, double value, int precision) {
+  const int result
+    = snprintf(buffer, size, "%.*g", precision ? precision : 17, value);
+  if (result < 0 || size_t(result) >= size - 2) {
+    return 0;
+  }
+  size_t length = result;
+
+  // keep the value a real when it is parsed again
+  if (strchr(buffer, '.') == nullptr && strchr(buffer, 'e') == nullptr) {
+    buffer[length++] = '.';
+    buffer[length++] = '0';
+    buffer[length] = '\0';
+  }
+
+  // drop '+' and leading zeros from the exponent
+  char *start = strchr(buffer, 'e');
+  if (start) {
+    start++;
+    char *end = start + 1;
+    if (*start == '-') {
+      start++;
+    }
+    while (*end == '0') {
+      end++;
+    }
+    if (end != start) {
+      memmove(start, end, length - size_t(end - buffer) + 1);
+      length -= size_t(end - start);
+    }
+  }
+  return length;
+}
+
+} // namespace
+
+JsonWriter::JsonWriter(const fs::FileObject &file, size_t buffer_size)
+  : m_file(file), m_buffer(buffer_size ? buffer_size : 1) {}
+
+JsonWriter::~JsonWriter() {
+  // errors can't be reported from the destructor
+  api::ErrorGuard error_guard;
+  flush();
+}
+
+JsonWriter &JsonWriter::begin_object() { return begin_container(true); }
+
+JsonWriter &JsonWriter::end_object() { return end_container(true); }
+
+JsonWriter &JsonWriter::begin_array() { return begin_container(false); }
+
+JsonWriter &JsonWriter::end_array() { return end_container(false); }
+
+JsonWriter &JsonWriter::key(const var::StringView key) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  if (
+    m_container_list.count() == 0 || !m_container_list.back().is_object
+    || m_is_key_pending) {
+    API_RETURN_VALUE_ASSIGN_ERROR(*this, "key must be in an object", EINVAL);
+  }
+
+  auto &container = m_container_list.back();
+  if (container.count) {
+    write(',');
+    write_indent(m_container_list.count(), true);
+  } else {
+    write_indent(m_container_list.count(), false);
+  }
+  container.count++;
+
+  write_escaped(key);
+  write(json_flags() & JSON_COMPACT ? ":" : ": ");
+  m_is_key_pending = true;
+  return *this;
+}
+
+JsonWriter &JsonWriter::string(const var::StringView value) {
+  if (begin_value().is_success()) {
+    write_escaped(value);
+  }
+  return *this;
+}
+
+JsonWriter &JsonWriter::integer(s64 value) {
+  if (begin_value().is_success()) {
+    char buffer[24];
+    const int length
+      = snprintf(buffer, sizeof(buffer), "%lld", (long long)value);
+    write(StringView(buffer, length));
+  }
+  return *this;
+}
+
+JsonWriter &JsonWriter::real(double value) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  if (std::isnan(value) || std::isinf(value)) {
+    API_RETURN_VALUE_ASSIGN_ERROR(*this, "real is not finite", EINVAL);
+  }
+
+  if (begin_value().is_success()) {
+    char buffer[32];
+    const size_t length = format_real(
+      buffer,
+      sizeof(buffer),
+      value,
+      (json_flags() >> 11) & 0x1f);
+    write(StringView(buffer, length));
+  }
+  return *this;
+}
+
+JsonWriter &JsonWriter::boolean(bool value) {
+  if (begin_value().is_success()) {
+    write(value ? "true" : "false");
+  }
+  return *this;
+}
+
+JsonWriter &JsonWriter::null() {
+  if (begin_value().is_success()) {
+    write("null");
+  }
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(const JsonValue &value) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  switch (value.type()) {
+  case JsonValue::Type::object: {
+    begin_object();
+    json_t *object = value.m_value;
+    for (void *iter = JsonValue::api()->object_iter(object);
+         iter && is_success();
+         iter = JsonValue::api()->object_iter_next(object, iter)) {
+      key(JsonValue::api()->object_iter_key(iter));
+      this->value(JsonValue(JsonValue::api()->object_iter_value(iter)));
+    }
+    return end_object();
+  }
+  case JsonValue::Type::array: {
+    begin_array();
+    const auto count = value.to_array().count();
+    for (u32 i = 0; i < count && is_success(); i++) {
+      this->value(value.to_array().at(i));
+    }
+    return end_array();
+  }
+  case JsonValue::Type::string:
+    return string(StringView(
+      JsonValue::api()->string_value(value.m_value),
+      JsonValue::api()->string_length(value.m_value)));
+  case JsonValue::Type::integer:
+    return integer(JsonValue::api()->integer_value(value.m_value));
+  case JsonValue::Type::real:
+    return real(JsonValue::api()->real_value(value.m_value));
+  case JsonValue::Type::true_:
+    return boolean(true);
+  case JsonValue::Type::false_:
+    return boolean(false);
+  case JsonValue::Type::null:
+    return null();
+  case JsonValue::Type::invalid:
+    break;
+  }
+  API_RETURN_VALUE_ASSIGN_ERROR(*this, "invalid value", EINVAL);
+}
+
+JsonWriter &JsonWriter::end_line() {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  if (depth() || m_is_key_pending) {
+    API_RETURN_VALUE_ASSIGN_ERROR(*this, "line record is incomplete", EINVAL);
+  }
+
+  if (indent()) {
+    API_RETURN_VALUE_ASSIGN_ERROR(*this, "line records must be compact", EINVAL);
+  }
+
+  write('\n');
+  return *this;
+}
+
+JsonWriter &JsonWriter::flush() {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  if (m_buffer_offset) {
+    m_file.write(View(m_buffer.data(), m_buffer_offset));
+    if (size_t(return_value()) != m_buffer_offset) {
+      m_buffer_offset = 0;
+      API_RETURN_VALUE_ASSIGN_ERROR(*this, "failed to write json", EIO);
+    }
+    m_buffer_offset = 0;
+  }
+  return *this;
+}
+
+JsonWriter &JsonWriter::begin_value() {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  if (m_container_list.count() == 0) {
+    return *this;
+  }
+
+  auto &container = m_container_list.back();
+  if (container.is_object) {
+    if (!m_is_key_pending) {
+      API_RETURN_VALUE_ASSIGN_ERROR(*this, "object value needs a key", EINVAL);
+    }
+    m_is_key_pending = false;
+    return *this;
+  }
+
+  if (container.count) {
+    write(',');
+    write_indent(m_container_list.count(), true);
+  } else {
+    write_indent(m_container_list.count(), false);
+  }
+  container.count++;
+  return *this;
+}
+
+JsonWriter &JsonWriter::begin_container(bool is_object) {
+  if (begin_value().is_success()) {
+    write(is_object ? '{' : '[');
+    m_container_list.push_back({is_object, 0});
+  }
+  return *this;
+}
+
+JsonWriter &JsonWriter::end_container(bool is_object) {
+  API_RETURN_VALUE_IF_ERROR(*this);
+  if (
+    m_container_list.count() == 0
+    || m_container_list.back().is_object != is_object || m_is_key_pending) {
+    API_RETURN_VALUE_ASSIGN_ERROR(*this, "no container to end", EINVAL);
+  }
+
+  const size_t count = m_container_list.back().count;
+  m_container_list.pop_back();
+  if (count) {
+    write_indent(m_container_list.count(), false);
+  }
+  write(is_object ? '}' : ']');
+  return *this;
+}
+
+void JsonWriter::write_indent(size_t depth, bool is_space) {
+  if (indent() > 0) {
+    write('\n');
+    for (size_t i = 0; i < depth * indent(); i++) {
+      write(' ');
+    }
+  } else if (is_space && !(json_flags() & JSON_COMPACT)) {
+    write(' ');
+  }
+}
+
+void JsonWriter::write_escaped(const var::StringView value) {
+  const bool is_ascii = json_flags() & JSON_ENSURE_ASCII;
+  const bool is_escape_slash = json_flags() & JSON_ESCAPE_SLASH;
+  const char *data = value.data();
+  const size_t length = value.length();
+
+  write('"');
+  size_t start = 0;
+  size_t position = 0;
+  while (position < length) {
+    const char c = data[position];
+    u32 codepoint = static_cast<u8>(c);
+    size_t count = 1;
+    if (is_ascii && codepoint >= 0x80) {
+      count = decode_utf8(data + position, length - position, codepoint);
+      if (count == 0) {
+        API_RETURN_ASSIGN_ERROR("invalid utf-8 string", EINVAL);
+      }
+    }
+
+    if (
+      c != '"' && c != '\\' && codepoint >= 0x20 && codepoint < 0x80
+      && (c != '/' || !is_escape_slash)) {
+      position++;
+      continue;
+    }
+
+    if (!is_ascii && codepoint >= 0x80) {
+      position++;
+      continue;
+    }
+
+    // copy the run of characters that don't need escaping
+    write(StringView(data + start, position - start));
+
+    switch (c) {
+    case '"':
+      write("\\\"");
+      break;
+    case '\\':
+      write("\\\\");
+      break;
+    case '/':
+      write("\\/");
+      break;
+    case '\b':
+      write("\\b");
+      break;
+    case '\f':
+      write("\\f");
+      break;
+    case '\n':
+      write("\\n");
+      break;
+    case '\r':
+      write("\\r");
+      break;
+    case '\t':
+      write("\\t");
+      break;
+    default: {
+      char buffer[13];
+      int buffer_length;
+      if (codepoint < 0x10000) {
+        buffer_length = snprintf(
+          buffer,
+          sizeof(buffer),
+          "\\u%04X",
+          static_cast<unsigned>(codepoint));
+      } else {
+        // surrogate pair
+        codepoint -= 0x10000;
+        buffer_length = snprintf(
+          buffer,
+          sizeof(buffer),
+          "\\u%04X\\u%04X",
+          static_cast<unsigned>(0xd800 | ((codepoint & 0xffc00) >> 10)),
+          static_cast<unsigned>(0xdc00 | (codepoint & 0x003ff)));
+      }
+      write(StringView(buffer, buffer_length));
+    } break;
+    }
+
+    position += count;
+    start = position;
+  }
+  write(StringView(data + start, position - start));
+  write('"');
+}
+
+void JsonWriter::write(const var::StringView value) {
+  const char *data = value.data();
+  size_t remaining = value.length();
+  while (remaining && is_success()) {
+    const size_t available = m_buffer.size() - m_buffer_offset;
+    const size_t page_size = remaining < available ? remaining : available;
+    memcpy(
+      static_cast<char *>(m_buffer.data()) + m_buffer_offset,
+      data,
+      page_size);
+    m_buffer_offset += page_size;
+    data += page_size;
+    remaining -= page_size;
+    if (m_buffer_offset == m_buffer.size()) {
+      flush();
+    }
+  }
+}
+
+void JsonWriter::write(char c) { write(StringView(&c, 1)); }
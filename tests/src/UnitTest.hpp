@@ -10,6 +10,22 @@
 using namespace fs;
 using namespace var;
 
+struct StructPort {
+  u16 number = 0;
+  bool is_open = false;
+};
+JSON_FIELDS(StructPort, number, is_open)
+
+struct StructSample {
+  u32 id = 0;
+  float voltage = 0.0f;
+  var::String name;
+  var::Vector<s32> list;
+  var::Vector<StructPort> port_list;
+  JsonTypedArray<float> samples;
+};
+JSON_FIELDS(StructSample, id, voltage, name, list, port_list, samples)
+
 class UnitTest : public test::Test {
 public:
   UnitTest(var::StringView name) : test::Test(name) {}
@@ -28,6 +44,13 @@ public:
     bool m_is_valid;
   };
 
+  class JsonSettings : public JsonValue {
+  public:
+    JSON_ACCESS_CONSTRUCT_OBJECT(JsonSettings);
+    JSON_ACCESS_STRING(JsonSettings, name);
+    JSON_ACCESS_INTEGER_WITH_KEY(JsonSettings, baudRate, baud_rate);
+  };
+
   bool execute_class_api_case() {
 
     JsonObject object;
@@ -51,7 +74,78 @@ public:
     TEST_ASSERT_RESULT(value_case());
     TEST_ASSERT_RESULT(document_case());
     TEST_ASSERT_RESULT(seek_case());
+    TEST_ASSERT_RESULT(seek_index_case());
+    TEST_ASSERT_RESULT(array_index_case());
+    TEST_ASSERT_RESULT(reader_case());
+    TEST_ASSERT_RESULT(writer_case());
+    TEST_ASSERT_RESULT(line_case());
+    TEST_ASSERT_RESULT(lazy_case());
+    TEST_ASSERT_RESULT(projection_case());
+    TEST_ASSERT_RESULT(incremental_case());
+    TEST_ASSERT_RESULT(query_case());
+    TEST_ASSERT_RESULT(struct_case());
+
+    return true;
+  }
 
+  bool execute_class_performance_case() {
+    TEST_ASSERT_RESULT(save_write_count_case());
+    return true;
+  }
+
+  bool save_write_count_case() {
+    // counts calls to write() without storing anything
+    class WriteCountFile : public fs::FileObject {
+    public:
+      size_t write_count() const { return m_write_count; }
+      size_t byte_count() const { return m_byte_count; }
+
+    private:
+      mutable size_t m_write_count = 0;
+      mutable size_t m_byte_count = 0;
+
+      int interface_lseek(int offset, int whence) const override { return 0; }
+      int interface_read(void *buf, int nbyte) const override { return 0; }
+      int interface_write(const void *buf, int nbyte) const override {
+        m_write_count++;
+        m_byte_count += nbyte;
+        return nbyte;
+      }
+      int interface_ioctl(int request, void *argument) const override {
+        return 0;
+      }
+    };
+
+    JsonArray array;
+    for (u32 i = 0; i < 1000; i++) {
+      array.append(JsonObject()
+                     .insert("index", JsonInteger(i))
+                     .insert("name", JsonString("record"))
+                     .insert("value", JsonReal(i * 0.5f)));
+    }
+
+    WriteCountFile unbuffered_file;
+    TEST_ASSERT(JsonDocument()
+                  .set_write_buffer_size(0)
+                  .save(array, unbuffered_file)
+                  .is_success());
+
+    WriteCountFile buffered_file;
+    TEST_ASSERT(JsonDocument().save(array, buffered_file).is_success());
+
+    printer().key(
+      "unbufferedWrites",
+      NumberString(unbuffered_file.write_count()).string_view());
+    printer().key(
+      "bufferedWrites",
+      NumberString(buffered_file.write_count()).string_view());
+
+    TEST_ASSERT(buffered_file.byte_count() == unbuffered_file.byte_count());
+    TEST_ASSERT(buffered_file.write_count() < unbuffered_file.write_count());
+    TEST_ASSERT(
+      buffered_file.write_count()
+      <= buffered_file.byte_count() / JsonDocument::default_write_buffer_size
+           + 1);
     return true;
   }
 
@@ -149,6 +243,581 @@ public:
       API_RESET_ERROR();
     }
 
+    {
+      // strings with escapes and brackets must not confuse the scanner
+      const DataFile nested_file
+        = DataFile()
+            .write(StringView(
+              R"({"text":"\\","list":["]}\"{",[[1],[2,{"name":"x"}]]]})"))
+            .seek(0)
+            .move();
+
+      JsonObject object = JsonDocument()
+                            .seek("/list/[1]/[1]/[1]", nested_file)
+                            .set_flags(JsonDocument::Flags::disable_eof_check)
+                            .load(nested_file);
+
+      TEST_ASSERT(is_success());
+      TEST_ASSERT(object.at("name").to_string_view() == "x");
+    }
+
+    return true;
+  }
+
+  bool seek_index_case() {
+    const DataFile json_file
+      = DataFile()
+          .write(StringView(
+            R"({"name":"archive","list":[{"id":1},{"id":2,"data":{"x":3}}]})"))
+          .seek(0)
+          .move();
+
+    DataFile index_file;
+    JsonSeekIndex().set_maximum_depth(2).build(json_file).save(index_file);
+    TEST_ASSERT(is_success());
+
+    index_file.seek(0);
+    JsonSeekIndex index;
+    TEST_ASSERT(index.load(index_file).is_success());
+    TEST_ASSERT(index.maximum_depth() == 2);
+    TEST_ASSERT(index.source_size() == json_file.size());
+    TEST_ASSERT(index.entry_list().count() == 4);
+    TEST_ASSERT(index.find("/list").start() == 25);
+    TEST_ASSERT(index.find("/list").size() == 34);
+    TEST_ASSERT(index.find("/name").is_valid() == false);
+
+    {
+      // indexed
+      JsonObject object = JsonDocument()
+                            .seek("/list/[1]", json_file, index)
+                            .set_flags(JsonDocument::Flags::disable_eof_check)
+                            .load(json_file);
+      TEST_ASSERT(object.at("id").to_integer() == 2);
+    }
+
+    {
+      // deeper than the index, scanned from /list/[1]
+      JsonObject object = JsonDocument()
+                            .seek("/list/[1]/data", json_file, index)
+                            .set_flags(JsonDocument::Flags::disable_eof_check)
+                            .load(json_file);
+      TEST_ASSERT(object.at("x").to_integer() == 3);
+    }
+
+    JsonDocument().seek("/list/[0]/data", json_file, index);
+    TEST_ASSERT(json_file.location() == int(json_file.size()));
+
+    StringViewList path_list;
+    path_list.push_back("/list/[1]/data");
+    path_list.push_back("/missing");
+    path_list.push_back("/list");
+
+    json_file.seek(0);
+    const auto entry_list = JsonDocument().seek_many(path_list, json_file);
+    TEST_ASSERT(entry_list.count() == 3);
+    TEST_ASSERT(entry_list.at(0).path() == "/list/[1]/data");
+    TEST_ASSERT(entry_list.at(0).start() == 50);
+    TEST_ASSERT(entry_list.at(0).size() == 7);
+    TEST_ASSERT(entry_list.at(1).is_valid() == false);
+    TEST_ASSERT(entry_list.at(2).start() == index.find("/list").start());
+    TEST_ASSERT(entry_list.at(2).size() == index.find("/list").size());
+
+    {
+      // the file ends inside the array
+      const DataFile truncated_file
+        = DataFile().write(StringView(R"({"list":[1,2)")).seek(0).move();
+      StringViewList list_path;
+      list_path.push_back("/list");
+      const auto truncated_entry
+        = JsonDocument().seek_many(list_path, truncated_file).at(0);
+      TEST_ASSERT(truncated_entry.is_valid() == false);
+      TEST_ASSERT(truncated_entry.start() == 0);
+      TEST_ASSERT(truncated_entry.size() == 0);
+    }
+
+    {
+      json_file.seek(0);
+      JsonObject object = JsonDocument().load_at("/list/[1]/data", json_file);
+      TEST_ASSERT(object.at("x").to_integer() == 3);
+      JsonArray array = JsonDocument().load_at("/list", json_file, index);
+      TEST_ASSERT(array.count() == 2);
+      object = JsonDocument().load_at(entry_list.at(0), json_file);
+      TEST_ASSERT(object.at("x").to_integer() == 3);
+      TEST_ASSERT(
+        JsonDocument().load_at("/list/[1]/data", json_file, index).is_valid());
+    }
+
+    TEST_ASSERT(
+      JsonDocument().load_at(entry_list.at(1), json_file).is_valid() == false);
+    TEST_ASSERT(is_error());
+    API_RESET_ERROR();
+
+    {
+      // the index is stale once the file changes size
+      DataFile changed_file = DataFile()
+                                .write(StringView(R"({"name":"a","list":[]})"))
+                                .seek(0)
+                                .move();
+      TEST_ASSERT(
+        JsonDocument().load_at("/list", changed_file, index).is_valid()
+        == false);
+      TEST_ASSERT(error().error_number() == ESTALE);
+      API_RESET_ERROR();
+
+      JsonDocument().seek("/list", changed_file, index);
+      TEST_ASSERT(is_error());
+      TEST_ASSERT(changed_file.location() == 0);
+      API_RESET_ERROR();
+    }
+    return true;
+  }
+
+  bool array_index_case() {
+    const DataFile json_file
+      = DataFile()
+          .write(StringView(R"([{"id":0}, 1 ,"two,]",[3,[4]],{"id":4}])"))
+          .seek(0)
+          .move();
+
+    DataFile index_file;
+    JsonArrayIndex().build(json_file).save(index_file);
+    TEST_ASSERT(is_success());
+
+    index_file.seek(0);
+    JsonArrayIndex index;
+    TEST_ASSERT(index.load(index_file).is_success());
+    TEST_ASSERT(index.count() == 5);
+    TEST_ASSERT(index.source_size() == json_file.size());
+
+    TEST_ASSERT(
+      JsonDocument().load_element(json_file, index, 1).to_integer() == 1);
+    TEST_ASSERT(
+      JsonDocument().load_element(json_file, index, 2).to_string_view()
+      == "two,]");
+    TEST_ASSERT(
+      JsonDocument()
+        .load_element(json_file, index, 4)
+        .to_object()
+        .at("id")
+        .to_integer()
+      == 4);
+
+    JsonArray page = JsonDocument().load_elements(json_file, index, 1, 4);
+    TEST_ASSERT(page.count() == 3);
+    TEST_ASSERT(page.at(2).to_array().count() == 2);
+
+    TEST_ASSERT(
+      JsonDocument().load_element(json_file, index, 5).is_valid() == false);
+    TEST_ASSERT(is_error());
+    API_RESET_ERROR();
+
+    {
+      // the array was rewritten after it was indexed
+      const DataFile changed_file
+        = DataFile().write(StringView(R"([{"id":0},12,"two"])")).seek(0).move();
+      TEST_ASSERT(
+        JsonDocument().load_element(changed_file, index, 1).is_valid()
+        == false);
+      TEST_ASSERT(error().error_number() == ESTALE);
+      API_RESET_ERROR();
+      TEST_ASSERT(
+        JsonDocument().load_elements(changed_file, index, 0, 2).count() == 0);
+      TEST_ASSERT(error().error_number() == ESTALE);
+      API_RESET_ERROR();
+    }
+
+    TEST_ASSERT(JsonArrayIndex()
+                  .build(DataFile().write(StringView(" [ ] ")).seek(0))
+                  .count()
+                == 0);
+    return true;
+  }
+
+  bool reader_case() {
+
+    class CountHandler : public JsonReader::Handler {
+    public:
+      bool start_object() override {
+        object_count++;
+        return true;
+      }
+      bool key(const var::StringView key) override {
+        key_count++;
+        return true;
+      }
+      bool integer(s64 value) override {
+        integer_total += value;
+        return true;
+      }
+      bool string(const var::StringView value) override {
+        last_string = value;
+        return true;
+      }
+      bool end_array(size_t count) override {
+        array_size = count;
+        return is_continue;
+      }
+
+      int object_count = 0;
+      int key_count = 0;
+      s64 integer_total = 0;
+      size_t array_size = 0;
+      bool is_continue = true;
+      KeyString last_string;
+    };
+
+    const StringView json
+      = R"({"name":"config","list":[1,2,3,{"value":4}],"other":"last"})";
+
+    {
+      CountHandler handler;
+      TEST_ASSERT(JsonReader().parse(json, handler).is_success());
+      TEST_ASSERT(handler.object_count == 2);
+      TEST_ASSERT(handler.key_count == 4);
+      TEST_ASSERT(handler.integer_total == 10);
+      TEST_ASSERT(handler.array_size == 4);
+      TEST_ASSERT(handler.last_string == "last");
+    }
+
+    {
+      const DataFile json_file = DataFile().write(json).seek(0).move();
+      CountHandler handler;
+      TEST_ASSERT(
+        JsonReader().set_buffer_size(8).parse(json_file, handler).is_success());
+      TEST_ASSERT(handler.key_count == 4);
+      TEST_ASSERT(handler.last_string == "last");
+    }
+
+    {
+      // stopping from the handler is not an error
+      CountHandler handler;
+      handler.is_continue = false;
+      TEST_ASSERT(JsonReader().parse(json, handler).is_success());
+      TEST_ASSERT(handler.last_string == "config");
+    }
+
+    {
+      CountHandler handler;
+      JsonReader reader;
+      TEST_ASSERT(reader.parse(R"({"name":})", handler).is_error());
+      TEST_ASSERT(reader.error().position() == 8);
+      API_RESET_ERROR();
+    }
+
+    return true;
+  }
+
+  bool writer_case() {
+
+    const JsonObject object
+      = JsonObject()
+          .insert("name", JsonString("\"quoted\"\n"))
+          .insert("count", JsonInteger(10))
+          .insert("real", JsonReal(2.5f))
+          .insert("empty", JsonArray())
+          .insert(
+            "list",
+            JsonArray()
+              .append(JsonTrue())
+              .append(JsonNull())
+              .append(JsonObject().insert("config", JsonString("stm32"))));
+
+    for (const auto flags :
+         {JsonDocument::Flags::indent3, JsonDocument::Flags::compact}) {
+      DataFile json_file;
+      JsonWriter(json_file)
+        .set_flags(flags)
+        .begin_object()
+        .key("name")
+        .string("\"quoted\"\n")
+        .key("count")
+        .integer(10)
+        .key("real")
+        .real(2.5)
+        .key("empty")
+        .begin_array()
+        .end_array()
+        .key("list")
+        .begin_array()
+        .boolean(true)
+        .null()
+        .value(JsonObject().insert("config", JsonString("stm32")))
+        .end_array()
+        .end_object();
+
+      TEST_ASSERT(is_success());
+      TEST_ASSERT(
+        JsonDocument()
+          .set_flags(flags | JsonDocument::Flags::preserve_order)
+          .to_string(object)
+        == StringView(json_file.data().add_null_terminator()));
+    }
+
+    {
+      JsonDocument document;
+      String output;
+      TEST_ASSERT(document.to_string(object, output).is_success());
+      TEST_ASSERT(output == document.to_string(object));
+      const auto capacity = output.capacity();
+      TEST_ASSERT(document.to_string(object, output).is_success());
+      TEST_ASSERT(output == document.to_string(object));
+      TEST_ASSERT(output.capacity() == capacity);
+    }
+
+    {
+      DataFile json_file;
+      TEST_ASSERT(JsonWriter(json_file).begin_object().integer(1).is_error());
+      API_RESET_ERROR();
+    }
+
+    return true;
+  }
+
+  bool line_case() {
+    DataFile json_file;
+    {
+      JsonWriter writer(json_file);
+      writer.set_flags(JsonDocument::Flags::compact);
+      for (int i = 0; i < 3; i++) {
+        writer.append_line(JsonObject().insert("index", JsonInteger(i)));
+      }
+      TEST_ASSERT(writer.is_success());
+    }
+    json_file.write(StringView("{\"index\":}\r\n\n"));
+    {
+      JsonWriter writer(json_file);
+      writer.set_flags(JsonDocument::Flags::compact)
+        .begin_object()
+        .key("index")
+        .integer(3)
+        .end_object()
+        .end_line();
+      TEST_ASSERT(writer.is_success());
+    }
+
+    {
+      DataFile incomplete_file;
+      TEST_ASSERT(
+        JsonWriter(incomplete_file).begin_array().end_line().is_error());
+      API_RESET_ERROR();
+    }
+
+    struct Context {
+      int total = 0;
+      int count = 0;
+      int error_line = 0;
+    } context;
+
+    json_file.seek(0);
+    TEST_ASSERT(JsonDocument()
+                  .for_each_line(
+                    json_file,
+                    [](const JsonValue &value,
+                       const JsonError &error,
+                       void *data) -> bool {
+                      auto *c = reinterpret_cast<Context *>(data);
+                      if (value.is_valid() == false) {
+                        c->error_line = error.line();
+                        return true;
+                      }
+                      c->count++;
+                      c->total += value.to_object().at("index").to_integer();
+                      return true;
+                    },
+                    &context)
+                  .is_success());
+
+    TEST_ASSERT(context.count == 4);
+    TEST_ASSERT(context.total == 6);
+    TEST_ASSERT(context.error_line == 4);
+
+#if defined __link
+    for (const auto is_ordered :
+         {JsonDocument::IsOrdered::yes, JsonDocument::IsOrdered::no}) {
+      Context parallel_context;
+      json_file.seek(0);
+      TEST_ASSERT(JsonDocument()
+                    .for_each_line(
+                      json_file,
+                      JsonDocument::ParallelOptions()
+                        .set_thread_count(2)
+                        .set_chunk_size(16)
+                        .set_is_ordered(is_ordered),
+                      [](const JsonValue &value,
+                         const JsonError &error,
+                         void *data) -> bool {
+                        auto *c = reinterpret_cast<Context *>(data);
+                        if (value.is_valid() == false) {
+                          c->error_line = error.line();
+                          return true;
+                        }
+                        c->count++;
+                        c->total
+                          += value.to_object().at("index").to_integer();
+                        return true;
+                      },
+                      &parallel_context)
+                    .is_success());
+
+      TEST_ASSERT(parallel_context.count == 4);
+      TEST_ASSERT(parallel_context.total == 6);
+      TEST_ASSERT(parallel_context.error_line == 4);
+    }
+
+    {
+      // a read error isn't taken as the end of the file
+      class UnreadableFile : public fs::FileAccess<UnreadableFile> {
+      private:
+        int interface_lseek(int offset, int whence) const override {
+          return 0;
+        }
+        int interface_read(void *buf, int nbyte) const override { return -1; }
+        int interface_write(const void *buf, int nbyte) const override {
+          return -1;
+        }
+        int interface_ioctl(int request, void *argument) const override {
+          return -1;
+        }
+      };
+
+      TEST_ASSERT(JsonDocument()
+                    .for_each_line(
+                      UnreadableFile(),
+                      JsonDocument::ParallelOptions().set_thread_count(2),
+                      [](const JsonValue &, const JsonError &, void *) {
+                        return true;
+                      },
+                      nullptr)
+                    .is_error());
+      API_RESET_ERROR();
+    }
+#endif
+    return true;
+  }
+
+  bool lazy_case() {
+    JsonLazyDocument document;
+    document.from_string(
+      R"({"name":"config","list":[1,2.5,"a,]}",{"value":4}],"other":null})");
+
+    const auto &root = document.root();
+    TEST_ASSERT(root.is_object());
+    TEST_ASSERT(root.count() == 3);
+    TEST_ASSERT(root.key_at(1) == "list");
+    TEST_ASSERT(root.at("list").count() == 4);
+    TEST_ASSERT(root.find("list/[1]").is_real());
+    TEST_ASSERT(root.find("list/[2]").to_value().to_string_view() == "a,]}");
+    TEST_ASSERT(root.find("list/[3]/value").to_value().to_integer() == 4);
+    TEST_ASSERT(root.find("{2}").is_null());
+    TEST_ASSERT(root.at("missing").is_valid() == false);
+
+    // a second walk uses the member offsets indexed by the first
+    const auto value = root.at("list").at(3).at("value");
+    TEST_ASSERT(
+      root.at("list").at(3).at("value").json().data() == value.json().data());
+    TEST_ASSERT(value.json() == "4");
+
+    const auto list = root.at("list").to_value();
+    TEST_ASSERT(list.is_array());
+    TEST_ASSERT(list.to_array().count() == 4);
+
+    int count = 0;
+    for (const auto &value : root.at("list")) {
+      TEST_ASSERT(value.is_valid());
+      count++;
+    }
+    TEST_ASSERT(count == 4);
+
+    TEST_ASSERT(JsonLazyDocument()
+                  .from_string(R"({"a":1 "b":2})")
+                  .root()
+                  .at("a")
+                  .is_valid()
+                  == false);
+    API_RESET_ERROR();
+    return true;
+  }
+
+  bool projection_case() {
+    const StringView json
+      = R"({"status":{"uptime":10,"load":[1,2,{"cpu":3}]},"log":[1,2,3],)"
+        R"("name":"device"})";
+
+    StringViewList projection;
+    projection.push_back("status/load/[2]/cpu");
+    projection.push_back("name");
+
+    const JsonObject object = JsonDocument().from_string(json, projection);
+    TEST_ASSERT(object.is_object());
+    TEST_ASSERT(object.at("log").is_valid() == false);
+    TEST_ASSERT(object.at("name").to_string_view() == "device");
+
+    const JsonObject status = object.at("status");
+    TEST_ASSERT(status.at("uptime").is_valid() == false);
+
+    // elements before the selected one are kept as null
+    const JsonArray load = status.at("load");
+    TEST_ASSERT(load.count() == 3);
+    TEST_ASSERT(load.at(0).is_null());
+    TEST_ASSERT(load.at(2).to_object().at("cpu").to_integer() == 3);
+
+    DataFile json_file;
+    json_file.write(json);
+    json_file.seek(0);
+    TEST_ASSERT(JsonDocument()
+                  .load(json_file, projection)
+                  .to_object()
+                  .at("name")
+                  .to_string_view()
+                == "device");
+
+    TEST_ASSERT(
+      JsonDocument().from_string(R"({"name":[})", projection).is_valid()
+      == false);
+    API_RESET_ERROR();
+    return true;
+  }
+
+  bool incremental_case() {
+    struct Context {
+      int count = 0;
+      int error_count = 0;
+      int total = 0;
+    } context;
+
+    auto callback
+      = [](const JsonValue &value, const JsonError &error, void *data) -> bool {
+      auto *c = reinterpret_cast<Context *>(data);
+      if (value.is_valid() == false) {
+        c->error_count++;
+        return true;
+      }
+      c->count++;
+      c->total += value.is_object() ? value.to_object().at("index").to_integer()
+                                    : value.to_integer();
+      return true;
+    };
+
+    const StringView json = R"({"index":1,"text":"}{"}{"index":2} 3 ]
+{"index":4} 5)";
+
+    // split the input into small chunks so values span calls to feed()
+    JsonIncrementalParser parser(callback, &context);
+    for (size_t offset = 0; offset < json.length(); offset += 3) {
+      const size_t size
+        = json.length() - offset < 3 ? json.length() - offset : 3;
+      parser.feed(View(json.data() + offset, size));
+    }
+    TEST_ASSERT(parser.finish().is_success());
+    TEST_ASSERT(context.count == 5);
+    TEST_ASSERT(context.error_count == 1);
+    TEST_ASSERT(context.total == 15);
+
+    TEST_ASSERT(JsonIncrementalParser(callback, &context)
+                  .feed(View(StringView(R"({"index":[)")))
+                  .finish()
+                  .is_error());
+    API_RESET_ERROR();
     return true;
   }
 
@@ -164,6 +833,71 @@ public:
 
     TEST_ASSERT(array.insert(1, JsonString("at1")).at(1).to_string() == "at1");
 
+    {
+      const auto list = array.integer_list();
+      TEST_ASSERT(list.count() == array.count());
+      TEST_ASSERT(list.at(2) == 5);
+      TEST_ASSERT(list.at(3) == 2);
+      TEST_ASSERT(array.float_list().at(3) == 2.5f);
+      TEST_ASSERT(array.bool_list().count() == array.count());
+      bool flags[2] = {};
+      TEST_ASSERT(array.copy_to(flags, 2, 4) == 2);
+      TEST_ASSERT(flags[0] == true && flags[1] == false);
+      TEST_ASSERT(array.string_view_list().at(6) == "null");
+    }
+
+    {
+      const JsonArray numbers = JsonDocument().from_string("[1,2,3.5,4]");
+      float values[3] = {};
+      TEST_ASSERT(
+        numbers.copy_to(values, 3, 1, JsonArray::IsStrict::yes) == 3);
+      TEST_ASSERT(values[1] == 3.5f && values[2] == 4.0f);
+      TEST_ASSERT(numbers.copy_to(values, 3, 4) == 0);
+
+      s32 integers[4] = {};
+      TEST_ASSERT(
+        numbers.copy_to(integers, 4, 0, JsonArray::IsStrict::yes) == 2);
+      TEST_ASSERT(is_error());
+      API_RESET_ERROR();
+
+      const JsonArray large = JsonDocument().from_string("[1,4294967296]");
+      TEST_ASSERT(
+        large.copy_to(integers, 2, 0, JsonArray::IsStrict::yes) == 1);
+      TEST_ASSERT(is_error());
+      API_RESET_ERROR();
+
+      var::Vector<s32> list;
+      TEST_ASSERT(numbers.copy_to(list).is_success());
+      TEST_ASSERT(list.count() == 4 && list.at(2) == 3);
+    }
+
+    {
+      const JsonValue root = JsonDocument().from_string(
+        R"({"list":[{"value":1},{"value":2},{"value":3}],"name":"sum"})");
+      const JsonRef list = root.to_object().view_at("list");
+      TEST_ASSERT(list.is_array() && list.count() == 3);
+
+      int total = 0;
+      for (const JsonRef item : list) {
+        total += item.at("value").to_integer();
+      }
+      TEST_ASSERT(total == 6);
+      const JsonArray values = root.to_object().at("list");
+      TEST_ASSERT(values.view_at(2).is_object());
+
+      size_t count = 0;
+      for (auto iter = root.view().begin(); iter != root.view().end(); ++iter) {
+        count++;
+        if (iter.key() == "name") {
+          TEST_ASSERT((*iter).to_string_view() == "sum");
+        }
+      }
+      TEST_ASSERT(count == 2);
+      const auto value_key = JsonKey::literal("value");
+      TEST_ASSERT(list.at(0).at(value_key).to_value().to_integer() == 1);
+      TEST_ASSERT(list.at(5).is_valid() == false);
+    }
+
     return true;
   }
 
@@ -204,6 +938,12 @@ public:
 
         TEST_ASSERT(is_success());
         TEST_ASSERT(load_object.is_object());
+
+        JsonObject mapped_object = JsonDocument().load_mapped("test.json");
+        TEST_ASSERT(is_success());
+        TEST_ASSERT(
+          JsonDocument().to_string(mapped_object)
+          == JsonDocument().to_string(load_object));
       }
 
       {
@@ -220,6 +960,132 @@ public:
     return true;
   }
 
+  bool struct_case() {
+    const StringView json
+      = R"({"id":7,"voltage":3,"extra":{"list":[1,[2]]},"name":"adc",)"
+        R"("list":[1,-2,3],"port_list":[{"number":80,"is_open":true},)"
+        R"({"number":443,"is_open":null}],"samples":[1.5,2]})";
+
+    StructSample sample;
+    TEST_ASSERT(JsonStruct().read(json, sample).is_success());
+    TEST_ASSERT(sample.id == 7);
+    TEST_ASSERT(sample.voltage == 3.0f);
+    TEST_ASSERT(sample.name == "adc");
+    TEST_ASSERT(sample.list.count() == 3);
+    TEST_ASSERT(sample.list.at(1) == -2);
+    TEST_ASSERT(sample.port_list.count() == 2);
+    TEST_ASSERT(sample.port_list.at(0).is_open);
+    TEST_ASSERT(sample.port_list.at(1).number == 443);
+    TEST_ASSERT(sample.port_list.at(1).is_open == false);
+    TEST_ASSERT(sample.samples.count() == 2);
+    TEST_ASSERT(sample.samples.at(0) == 1.5f);
+
+    {
+      // written without a JsonValue tree and read back
+      DataFile json_file;
+      TEST_ASSERT(JsonStruct().write(json_file, sample).is_success());
+      const StringView output(json_file.data().add_null_terminator());
+      const JsonObject object = JsonDocument().from_string(output);
+      TEST_ASSERT(object.at("name").to_string_view() == "adc");
+      TEST_ASSERT(object.at("port_list").to_array().count() == 2);
+
+      StructSample copy;
+      TEST_ASSERT(JsonStruct().read(output, copy).is_success());
+      TEST_ASSERT(copy.port_list.at(0).number == 80);
+      TEST_ASSERT(copy.list.at(2) == 3);
+      TEST_ASSERT(copy.samples.at(1) == 2.0f);
+    }
+
+    {
+      JsonTypedArray<float> waveform;
+      TEST_ASSERT(waveform.read("[0, 0.5, 1, -2.25]").is_success());
+      TEST_ASSERT(waveform.count() == 4);
+      TEST_ASSERT(waveform.at(3) == -2.25f);
+      float total = 0.0f;
+      for (const float sample : waveform) {
+        total += sample;
+      }
+      TEST_ASSERT(total == -0.75f);
+
+      const JsonArray array = waveform.to_array();
+      TEST_ASSERT(array.count() == 4 && array.at(1).to_real() == 0.5f);
+      TEST_ASSERT(JsonTypedArray<double>(array).at(1) == 0.5);
+      // the same range and type rules as read()
+      TEST_ASSERT(JsonTypedArray<s16>(array).is_error());
+      API_RESET_ERROR();
+      const JsonArray integers = JsonDocument().from_string("[1,-2,70000]");
+      TEST_ASSERT(JsonTypedArray<s16>(integers).is_error());
+      API_RESET_ERROR();
+      TEST_ASSERT(JsonTypedArray<s32>(integers).at(2) == 70000);
+
+      DataFile json_file;
+      TEST_ASSERT(waveform.write(json_file).is_success());
+      TEST_ASSERT(
+        JsonTypedArray<double>()
+          .read(StringView(json_file.data().add_null_terminator()))
+          .count()
+        == 4);
+
+      TEST_ASSERT(JsonTypedArray<s32>().read("[1,\"2\"]").is_error());
+      API_RESET_ERROR();
+    }
+
+    {
+      // null elements keep the positions of the elements after them
+      var::Vector<s32> list;
+      TEST_ASSERT(JsonStruct().read("[1,null,2]", list).is_success());
+      TEST_ASSERT(list.count() == 3);
+      TEST_ASSERT(list.at(1) == 0 && list.at(2) == 2);
+    }
+
+    {
+      StructPort port;
+      TEST_ASSERT(JsonStruct().read(R"({"number":-1})", port).is_error());
+      API_RESET_ERROR();
+      TEST_ASSERT(JsonStruct().read(R"({"number":"80"})", port).is_error());
+      API_RESET_ERROR();
+      TEST_ASSERT(JsonStruct().read(R"({"number":80,)", port).is_error());
+      API_RESET_ERROR();
+    }
+    return true;
+  }
+
+  bool query_case() {
+    const JsonValue root = JsonDocument().from_string(
+      R"({"devices":[{"id":1,"status":"up"},{"id":2,"status":"down"},)"
+      R"({"id":3,"status":"up","port":{"id":4}}],"list":[0,1,2,3,4]})");
+
+    {
+      const auto result
+        = JsonQuery("$.devices[?(@.status == 'up')].id").find(root);
+      TEST_ASSERT(result.count() == 2);
+      TEST_ASSERT(result.at(0).to_integer() == 1);
+      TEST_ASSERT(result.at(1).to_integer() == 3);
+    }
+
+    TEST_ASSERT(JsonQuery("$..id").find(root).count() == 4);
+    TEST_ASSERT(JsonQuery("$.devices[*].status").find(root).count() == 3);
+    TEST_ASSERT(JsonQuery("$['devices'][-1].port.id").find(root).count() == 1);
+    TEST_ASSERT(JsonQuery("$.list[1:4]").find(root).at(2).to_integer() == 3);
+    TEST_ASSERT(JsonQuery("$.list[::-2]").find(root).at(1).to_integer() == 2);
+    TEST_ASSERT(
+      JsonQuery("$.list[?(@ > 1 && @ < 4)]").find(root).count() == 2);
+
+    int count = 0;
+    JsonQuery("$..id").for_each(
+      root,
+      [](JsonRef value, void *context) {
+        (*static_cast<int *>(context))++;
+        return value.is_integer();
+      },
+      &count);
+    TEST_ASSERT(count == 4);
+
+    TEST_ASSERT(JsonQuery("devices").is_valid() == false);
+    TEST_ASSERT(JsonQuery("$.list[::0]").is_valid() == false);
+    return true;
+  }
+
   bool value_case() {
     TEST_ASSERT(JsonString().assign("test").is_string());
     TEST_ASSERT(JsonInteger().assign("10").to_integer() == 10);
@@ -246,6 +1112,86 @@ public:
       TEST_ASSERT(JsonNull().is_null() == true);
     }
 
+    {
+      JsonSettings settings;
+      settings.set_name("uart").set_baud_rate(115200);
+      TEST_ASSERT(settings.get_name() == "uart");
+      TEST_ASSERT(settings.get_baud_rate() == 115200);
+      TEST_ASSERT(
+        JsonSettings::baud_rate_json_key().string_view() == "baudRate");
+
+      static const auto key = JsonKey::literal("baudRate");
+      TEST_ASSERT(settings.to_object().at(key).to_integer() == 115200);
+      TEST_ASSERT(
+        settings.to_object().at(JsonKey::literal("none")).is_valid() == false);
+
+      // runtime strings are copied with their string length
+      char buffer[16] = "baudRate";
+      const JsonOwnedKey copied(buffer);
+      buffer[0] = 'x';
+      TEST_ASSERT(copied.length() == 8);
+      TEST_ASSERT(settings.to_object().at(copied).to_integer() == 115200);
+
+      const var::String name("port");
+      const JsonOwnedKey port(name.string_view());
+      JsonObject object;
+      object.insert(port, JsonInteger(1)).insert(port, JsonInteger(2));
+      TEST_ASSERT(object.count() == 1);
+      TEST_ASSERT(object.at(port).to_integer() == 2);
+      TEST_ASSERT(port == JsonKey::literal("port"));
+      TEST_ASSERT(object.remove(port).count() == 0);
+
+      settings.remove_baud_rate();
+      TEST_ASSERT(settings.to_object().at("baudRate").is_valid() == false);
+    }
+
+    {
+      const JsonValue root = JsonDocument().from_string(
+        R"({"status":{"list":[1,2,{"name":"x"}]},"mode":"fast"})");
+      const JsonPath path("status/list/[2]/name");
+      TEST_ASSERT(path.is_valid());
+      TEST_ASSERT(path.count() == 4);
+      TEST_ASSERT(path.at(1).type() == JsonPath::Type::key);
+      TEST_ASSERT(path.at(2).type() == JsonPath::Type::array_offset);
+      TEST_ASSERT(path.at(2).offset() == 2);
+      TEST_ASSERT(root.find(path).to_string_view() == "x");
+      TEST_ASSERT(
+        path.at(0).key_hash()
+        == JsonKey::literal("status").hash());
+      TEST_ASSERT(root.find("status/list/[1]").to_integer() == 2);
+      TEST_ASSERT(root.find("/status/list/[1]").to_integer() == 2);
+      TEST_ASSERT(root.find("{1}").to_string_view() == "fast");
+      TEST_ASSERT(root.lookup(JsonPath("/status/list/0")).to_integer() == 1);
+      TEST_ASSERT(root.lookup("/status/list/2/name").to_string_view() == "x");
+
+      TEST_ASSERT(JsonPath("status//list").is_valid() == false);
+      TEST_ASSERT(root.find(JsonPath("status/list/[3]")).is_valid() == false);
+      TEST_ASSERT(is_error());
+      API_RESET_ERROR();
+    }
+
+    {
+      JsonValue root
+        = JsonDocument().from_string(R"({"a/b":[1,2],"m~n":{"x":3}})");
+      TEST_ASSERT(JsonPointer("/a~1b/1").get(root).to_integer() == 2);
+      TEST_ASSERT(JsonPointer("/m~0n/x").get(root).to_integer() == 3);
+      TEST_ASSERT(JsonPointer("/a~1b/01").get(root).is_valid() == false);
+      TEST_ASSERT(JsonPointer("a").is_valid() == false);
+      TEST_ASSERT(JsonPointer::escape("a/b~") == "a~1b~0");
+
+      JsonPointer("/a~1b/-").set(root, JsonInteger(3));
+      TEST_ASSERT(JsonPointer("/a~1b/2").get(root).to_integer() == 3);
+      JsonPointer("/config/list/0/name").set(root, JsonString("x"));
+      TEST_ASSERT(JsonPointer("/config/list").get(root).is_array());
+      TEST_ASSERT(
+        JsonPointer("/config/list/0/name").get(root).to_string_view() == "x");
+      TEST_ASSERT(is_success());
+
+      JsonPointer("/a~1b/9").set(root, JsonInteger(3));
+      TEST_ASSERT(is_error());
+      API_RESET_ERROR();
+    }
+
     return true;
   }
 
@@ -323,6 +1269,29 @@ public:
       TEST_ASSERT(object.at("array").to_array().at(3).to_bool() == true);
       TEST_ASSERT(object.at("array").to_array().at(4).to_bool() == false);
       TEST_ASSERT(object.at("array").to_array().at(5).is_null() == true);
+
+      {
+        const JsonObjectIndex index(object);
+        TEST_ASSERT(index.count() == object.count());
+        size_t offset = 0;
+        for (auto iter = object.begin(); iter != object.end(); ++iter) {
+          TEST_ASSERT(index.key_at(offset) == iter.key());
+          TEST_ASSERT(
+            index.at(offset).native_value() == (*iter).native_value());
+          TEST_ASSERT(
+            object.at(offset).native_value() == (*iter).native_value());
+          offset++;
+        }
+        TEST_ASSERT(index.at(offset).is_valid() == false);
+
+        // members removed through another copy are invalid, not dangling
+        const var::String key(index.key_at(0));
+        JsonObject copy = object;
+        copy.remove(key.string_view());
+        TEST_ASSERT(index.key_at(0) == key.string_view());
+        TEST_ASSERT(index.at(0).is_valid() == false);
+        TEST_ASSERT(index.at(1).is_valid());
+      }
     }
     return true;
   }